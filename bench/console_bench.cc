@@ -0,0 +1,481 @@
+#include <benchmark/benchmark.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+#include "console.h"
+#include "console_base.h"
+#include "fast_format.h"
+#include "telemetry_table.h"
+#include "thread_manager.h"
+#include "window_aggregator.h"
+
+// -----------------------------
+// Allocation counting
+// -----------------------------
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// @brief Frames are formatted but not written, so runs are reproducible in headless CI
+std::shared_ptr<OutputSink> NullTerminal() {
+    return std::make_shared<NullSink>();
+}
+
+/// @brief NullSink reporting a terminal of the given size
+class SizedNullSink : public NullSink {
+public:
+    explicit SizedNullSink(TerminalSize size) : size_(size) {}
+    TerminalSize Size() const override { return size_; }
+
+private:
+    TerminalSize size_;
+};
+
+std::shared_ptr<spdlog::logger> NullLogger() {
+    static auto logger = std::make_shared<spdlog::logger>(
+        "bench", std::make_shared<spdlog::sinks::null_sink_mt>());
+    return logger;
+}
+
+/// @brief Default bounds of a console queue of the given kind, the
+/// lock-free ring only sheds incoming rows
+QueueLimits LimitsFor(ExecutorKind kind) {
+    QueueLimits limits;
+    if (kind == ExecutorKind::LockFree)
+        limits.telemetry = TelemetryOverflow::DropNewest;
+    return limits;
+}
+
+std::vector<Column> MakeColumns(size_t n) {
+    std::vector<Column> columns;
+    for (size_t i = 0; i < n; ++i)
+        columns.push_back({"ch" + std::to_string(i), i == 0 ? ColumnAlign::Center : ColumnAlign::Left});
+    return columns;
+}
+
+TelemetrySample MakeSample(SchemaHandle schema, size_t columns, double v) {
+    TelemetrySample sample{schema};
+    for (size_t c = 0; c < columns; ++c)
+        sample.push(v + static_cast<double>(c));
+    return sample;
+}
+
+/// @brief Forwards to a printer and stamps the time each render finishes
+/// Samples carry their post time in values[0].i
+class LatencyProbe : public IConsole {
+public:
+    explicit LatencyProbe(IConsole& inner) : inner_(inner) {}
+
+    size_t newStatus(const IStatusPrint& status) override { return inner_.newStatus(status); }
+    bool addTelemetry(const ITelemetryPrint telem) override { return inner_.addTelemetry(telem); }
+    SchemaHandle registerSchema(std::vector<Column> columns, int precision) override
+        { return inner_.registerSchema(std::move(columns), precision); }
+    SchemaHandle registerStaticSchema(std::vector<Column> columns, int precision, const StaticLayout& layout) override
+        { return inner_.registerStaticSchema(std::move(columns), precision, layout); }
+    TableId addTable(const TableOptions& options) override { return inner_.addTable(options); }
+    bool addSample(const TelemetrySample& sample) override {
+        pending_.push_back(sample.values[0].i);
+        return inner_.addSample(sample);
+    }
+    size_t startPolling(const IStatusPrint& status) override { return inner_.startPolling(status); }
+    void stopPolling(size_t id, const IStatusPrint& status) override { inner_.stopPolling(id, status); }
+    bool advanceAnimations(Clock::time_point now) override { return inner_.advanceAnimations(now); }
+    void printTelemTable(bool full_redraw) override {
+        inner_.printTelemTable(full_redraw);
+        int64_t now = Clock::now().time_since_epoch().count();
+        for (int64_t posted : pending_)
+            latencies_.push_back(now - posted);
+        pending_.clear();
+    }
+    std::vector<std::string> convert_data(const std::vector<double>& data) override
+        { return inner_.convert_data(data); }
+
+    std::vector<int64_t> latencies_;
+
+private:
+    IConsole& inner_;
+    std::vector<int64_t> pending_;
+};
+
+}  // namespace
+
+// -----------------------------
+// Producer post throughput vs. thread count
+// -----------------------------
+static void BM_PostThroughput(benchmark::State& state) {
+    auto kind = static_cast<ExecutorKind>(state.range(0));
+    auto producers = static_cast<size_t>(state.range(1));
+    constexpr size_t kPostsPerThread = 20000;
+    ConsoleTablePrinter printer(NullLogger(), 12, 12, 16, NullTerminal());
+    auto schema = printer.registerSchema(MakeColumns(4), 2);
+
+    uint64_t dropped = 0;
+    for (auto _ : state) {
+        ThreadManager tm(kind, ConsoleRefresh{}, LimitsFor(kind));
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < producers; ++t)
+            threads.emplace_back([&] {
+                for (size_t i = 0; i < kPostsPerThread; ++i)
+                    tm.PostSample(printer, MakeSample(schema, 4, static_cast<double>(i)));
+            });
+        for (auto& t : threads)
+            t.join();
+        dropped += tm.ExecutorStats().dropped;
+    }
+    state.SetItemsProcessed(state.iterations() * producers * kPostsPerThread);
+    state.counters["dropped_pct"] =
+        100.0 * static_cast<double>(dropped) / static_cast<double>(state.iterations() * producers * kPostsPerThread);
+}
+BENCHMARK(BM_PostThroughput)
+    ->ArgNames({"lockfree", "threads"})
+    ->ArgsProduct({{0, 1}, {1, 2, 4, 8, 12}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// -----------------------------
+// Batched vs. one task per row, by batch size
+// -----------------------------
+static void BM_PostBatch(benchmark::State& state) {
+    auto batch_size = static_cast<size_t>(state.range(0));
+    constexpr size_t kRows = 20000;
+    ConsoleTablePrinter printer(NullLogger(), 12, 12, 16, NullTerminal());
+    auto schema = printer.registerSchema(MakeColumns(4), 2);
+
+    for (auto _ : state) {
+        QueueLimits limits;
+        limits.telemetry = TelemetryOverflow::Wait;
+        ThreadManager tm(ExecutorKind::LockFree, ConsoleRefresh{0}, std::move(limits));
+        for (size_t i = 0; i < kRows; i += batch_size) {
+            if (batch_size == 1) {
+                tm.PostSample(printer, MakeSample(schema, 4, static_cast<double>(i)));
+                continue;
+            }
+            auto batch = tm.BeginBatch(printer);
+            for (size_t n = 0; n < batch_size; ++n)
+                batch.Sample(MakeSample(schema, 4, static_cast<double>(i + n)));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kRows);
+}
+BENCHMARK(BM_PostBatch)
+    ->ArgName("batch")
+    ->Arg(1)->Arg(8)->Arg(64)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// -----------------------------
+// End-to-end post-to-render latency percentiles
+// -----------------------------
+static void BM_PostToRenderLatency(benchmark::State& state) {
+    ConsoleRefresh refresh{static_cast<double>(state.range(0)), CoalescePolicy::KeepAll};
+    ConsoleTablePrinter printer(NullLogger(), 12, 12, 16, NullTerminal());
+    LatencyProbe probe(printer);
+    auto schema = printer.registerSchema(MakeColumns(4), 2);
+
+    for (auto _ : state) {
+        {
+            ThreadManager tm(ExecutorKind::LockFree, refresh, LimitsFor(ExecutorKind::LockFree));
+            for (size_t i = 0; i < 2000; ++i) {
+                TelemetrySample sample{schema};
+                sample.push(Clock::now().time_since_epoch().count()).push(1.0).push(2.0).push(3.0);
+                tm.PostSample(probe, sample);
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    auto& lat = probe.latencies_;
+    std::sort(lat.begin(), lat.end());
+    auto pct = [&](double p) {
+        return lat.empty() ? 0.0 : static_cast<double>(lat[static_cast<size_t>(p * (lat.size() - 1))]) / 1e3;
+    };
+    state.counters["p50_us"] = pct(0.50);
+    state.counters["p90_us"] = pct(0.90);
+    state.counters["p99_us"] = pct(0.99);
+    state.counters["p999_us"] = pct(0.999);
+}
+BENCHMARK(BM_PostToRenderLatency)
+    ->ArgName("rate_hz")
+    ->Arg(0)->Arg(30)->Arg(120)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// -----------------------------
+// Allocations per telemetry sample (post + render)
+// -----------------------------
+static void BM_AllocationsPerSample(benchmark::State& state) {
+    bool typed = state.range(0) != 0;
+    ConsoleTablePrinter printer(NullLogger(), 12, 12, 16, NullTerminal());
+    auto columns = MakeColumns(8);
+    auto schema = printer.registerSchema(columns, 2);
+    std::vector<double> values(8, 1.25);
+    constexpr size_t kSamples = 10000;
+
+    // every sample is drawn: posters wait instead of shedding rows
+    QueueLimits limits;
+    limits.telemetry = TelemetryOverflow::Wait;
+
+    size_t allocations = 0;
+    for (auto _ : state) {
+        size_t before;
+        {
+            ThreadManager tm(ExecutorKind::LockFree, ConsoleRefresh{0}, limits);
+            before = g_allocations.load();
+            for (size_t i = 0; i < kSamples; ++i) {
+                if (typed)
+                    tm.PostSample(printer, MakeSample(schema, 8, static_cast<double>(i)));
+                else
+                    tm.PostTelem(printer, {columns, printer.convert_data(values)});
+            }
+        } // the console thread has drawn every post once tm is gone
+        allocations += g_allocations.load() - before;
+    }
+    state.counters["allocs_per_sample"] =
+        static_cast<double>(allocations) / static_cast<double>(state.iterations() * kSamples);
+}
+BENCHMARK(BM_AllocationsPerSample)
+    ->ArgName("typed")
+    ->Arg(0)->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+// -----------------------------
+// Allocations per status post (headers already interned)
+// -----------------------------
+static void BM_AllocationsPerStatus(benchmark::State& state) {
+    ConsoleTablePrinter printer(NullLogger(), 12, 12, 16, NullTerminal());
+    const char* headers[] = {"Sixdof", "Controller", "Server"};
+    constexpr size_t kStatuses = 10000;
+
+    size_t allocations = 0;
+    for (auto _ : state) {
+        size_t before;
+        {
+            ThreadManager tm(ExecutorKind::LockFree, ConsoleRefresh{0}, LimitsFor(ExecutorKind::LockFree));
+            before = g_allocations.load();
+            for (size_t i = 0; i < kStatuses; ++i)
+                tm.PostStatus(printer, {ConsoleLevels::INFO, headers[i % 3], "steady state status"});
+        } // drawn by the console thread before tm is gone
+        allocations += g_allocations.load() - before;
+    }
+    state.counters["allocs_per_status"] =
+        static_cast<double>(allocations) / static_cast<double>(state.iterations() * kStatuses);
+}
+BENCHMARK(BM_AllocationsPerStatus)
+    ->Unit(benchmark::kMillisecond);
+
+// -----------------------------
+// Bytes emitted per frame vs. table width and max_rows
+// -----------------------------
+static void BM_BytesPerFrame(benchmark::State& state) {
+    auto columns = static_cast<size_t>(state.range(0));
+    auto max_rows = static_cast<size_t>(state.range(1));
+    // a real writev per frame, to count the syscalls
+    ConsoleTablePrinter printer(NullLogger(), 12, max_rows, 16, std::make_shared<FileSink>("/dev/null"));
+    auto schema = printer.registerSchema(MakeColumns(columns), 2);
+
+    // fill the ring so every frame scrolls the whole table
+    for (size_t i = 0; i < max_rows; ++i)
+        printer.addSample(MakeSample(schema, columns, static_cast<double>(i)));
+    printer.printTelemTable(true);
+    auto start = printer.frameStats();
+
+    double v = 0;
+    for (auto _ : state) {
+        printer.addSample(MakeSample(schema, columns, v += 1.0));
+        printer.printTelemTable(false);
+    }
+
+    auto end = printer.frameStats();
+    auto frames = static_cast<double>(end.frames - start.frames);
+    state.counters["bytes_per_frame"] = static_cast<double>(end.total_bytes - start.total_bytes) / frames;
+    state.counters["syscalls_per_frame"] = static_cast<double>(end.total_syscalls - start.total_syscalls) / frames;
+    state.SetBytesProcessed(static_cast<int64_t>(end.total_bytes - start.total_bytes));
+}
+BENCHMARK(BM_BytesPerFrame)
+    ->ArgNames({"columns", "max_rows"})
+    ->ArgsProduct({{3, 8, 32}, {5, 12, 50}});
+
+// -----------------------------
+// Redrawing a 32 column table vs. terminal width (0: unlimited)
+// -----------------------------
+static void BM_VisibleColumns(benchmark::State& state) {
+    constexpr size_t kColumns = 32;
+    constexpr size_t kRows = 12;
+    auto size = TerminalSize{static_cast<size_t>(state.range(0)), 0};
+    ConsoleTablePrinter printer(NullLogger(), 12, kRows, 16, std::make_shared<SizedNullSink>(size));
+    auto schema = printer.registerSchema(MakeColumns(kColumns), 2);
+    for (size_t i = 0; i < kRows; ++i)
+        printer.addSample(MakeSample(schema, kColumns, static_cast<double>(i)));
+    printer.printTelemTable(true);
+    auto start = printer.frameStats();
+
+    double v = 0;
+    for (auto _ : state) {
+        printer.addSample(MakeSample(schema, kColumns, v += 1.0));
+        printer.printTelemTable(false);
+    }
+
+    auto end = printer.frameStats();
+    state.counters["bytes_per_frame"] = static_cast<double>(end.total_bytes - start.total_bytes) /
+                                        static_cast<double>(end.frames - start.frames);
+}
+BENCHMARK(BM_VisibleColumns)
+    ->ArgName("terminal_columns")
+    ->Arg(0)->Arg(200)->Arg(80);
+
+// -----------------------------
+// Rebuilding every table of a busy frame vs. formatting threads
+// -----------------------------
+static void BM_FormatThreads(benchmark::State& state) {
+    constexpr size_t kTables = 8;
+    constexpr size_t kColumns = 16;
+    auto rows = static_cast<size_t>(state.range(1));
+    ConsoleTablePrinter printer(NullLogger(), 12, rows, 16, NullTerminal());
+    printer.setFormatThreads(static_cast<size_t>(state.range(0)));
+    auto schema = printer.registerSchema(MakeColumns(kColumns), 2);
+    for (size_t t = 1; t < kTables; ++t)
+        printer.addTable(TableOptions{"table" + std::to_string(t), rows});
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t t = 0; t < kTables; ++t){
+            TelemetrySample sample = MakeSample(schema, kColumns, static_cast<double>(i));
+            sample.table = static_cast<TableId>(t);
+            printer.addSample(sample);
+        }
+    printer.printTelemTable(true);
+
+    double v = 0;
+    for (auto _ : state) {
+        // every table scrolls, so every row of every table is formatted again
+        for (size_t t = 0; t < kTables; ++t){
+            TelemetrySample sample = MakeSample(schema, kColumns, v += 1.0);
+            sample.table = static_cast<TableId>(t);
+            printer.addSample(sample);
+        }
+        printer.printTelemTable(false);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kTables * rows));
+}
+BENCHMARK(BM_FormatThreads)
+    ->ArgNames({"threads", "rows"})
+    ->ArgsProduct({{1, 2, 4, 8}, {12, 50, 200}})
+    ->UseRealTime();
+
+// -----------------------------
+// Window aggregation cost per sample vs. column count
+// -----------------------------
+static void BM_WindowAggregate(benchmark::State& state) {
+    auto columns = static_cast<size_t>(state.range(0));
+    auto schema_columns = MakeColumns(columns);
+    for (size_t c = 0; c < columns; ++c)
+        schema_columns[c].aggregate = static_cast<Aggregate>(c % 6);
+    WindowAggregator window;
+    TelemetrySample summary;
+    double v = 0;
+    for (auto _ : state) {
+        v += 1.0;
+        window.Add(MakeSample(0, columns, v), v * 1e-3);
+        if (window.count() == 100) {
+            window.Summarize(schema_columns, summary);
+            benchmark::DoNotOptimize(summary);
+            window.Reset();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WindowAggregate)
+    ->ArgName("columns")
+    ->Arg(4)->Arg(8)->Arg(32);
+
+// -----------------------------
+// Formatting one 32 channel row: fmt per value vs. the fixed-point path
+// -----------------------------
+static std::vector<double> MakeRowValues() {
+    std::vector<double> row;
+    for (size_t c = 0; c < 32; ++c)
+        row.push_back(static_cast<double>(c) * 137.31 - 1500.0 + 0.004 * static_cast<double>(c));
+    return row;
+}
+
+static void BM_FormatRowFmt(benchmark::State& state) {
+    auto row = MakeRowValues();
+    const std::string spec = "{:.2f}";
+    for (auto _ : state) {
+        std::vector<std::string> out;
+        out.reserve(row.size());
+        for (double v : row)
+            out.push_back(fmt::format(spec, v));
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * row.size());
+}
+BENCHMARK(BM_FormatRowFmt);
+
+static void BM_FormatRowConvertToStrings(benchmark::State& state) {
+    auto row = MakeRowValues();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(convert_to_strings(row));
+    state.SetItemsProcessed(state.iterations() * row.size());
+}
+BENCHMARK(BM_FormatRowConvertToStrings);
+
+static void BM_FormatRowFixed(benchmark::State& state) {
+    auto row = MakeRowValues();
+    char buf[32 * fast_format::kMaxCellChars];
+    size_t ends[32];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fast_format::FormatRow<2>(row.data(), row.size(), buf, sizeof(buf), ends));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * row.size());
+}
+BENCHMARK(BM_FormatRowFixed);
+
+// -----------------------------
+// Rebuilding an 8 column table: runtime schema vs. TelemetryTable
+// -----------------------------
+template<size_t N>
+struct BenchColumn : TableColumn<double, N % 2 ? ColumnAlign::Left : ColumnAlign::Center> {
+    static constexpr std::string_view name = "channel";
+};
+using BenchTable = TelemetryTable<BenchColumn<0>, BenchColumn<1>, BenchColumn<2>, BenchColumn<3>,
+                                  BenchColumn<4>, BenchColumn<5>, BenchColumn<6>, BenchColumn<7>>;
+
+static void BM_BuildTable(benchmark::State& state) {
+    bool typed = state.range(0) != 0;
+    constexpr size_t kRows = 12;
+    ConsoleTablePrinter printer(NullLogger(), 12, kRows, 16, NullTerminal());
+    BenchTable table(printer);
+    auto schema = typed ? table.schema() : printer.registerSchema(MakeColumns(BenchTable::kColumns), 2);
+
+    double v = 0;
+    for (auto _ : state) {
+        // a new row marks the table dirty, the full redraw formats every row
+        printer.addSample(MakeSample(schema, BenchTable::kColumns, v += 1.0));
+        printer.printTelemTable(true);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kRows * BenchTable::kColumns));
+}
+BENCHMARK(BM_BuildTable)
+    ->ArgName("typed")
+    ->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -1,5 +1,4 @@
 #include <spdlog/spdlog.h>
-#include <spdlog/sinks/stdout_color_sinks.h>
 
 #include <fmt/format.h>
 #include <fmt/args.h>
@@ -10,29 +9,198 @@
 #include <chrono>
 #include <vector>
 #include <csignal>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
 #include "src/console.h"
 #include "src/console_base.h"
+#include "src/flight_replay.h"
+#include "src/instrumentation.h"
+#include "src/shm_console.h"
+#include "src/signal_watcher.h"
+#include "src/system_log.h"
+#include "src/telemetry_table.h"
 #include "src/thread_manager.h"
 
-int main()
+// columns of the demo tables, laid out at compile time
+struct TimeCol : TableColumn<double, ColumnAlign::Center> { static constexpr std::string_view name = "Time(s)"; };
+struct AglCol : TableColumn<double> { static constexpr std::string_view name = "Agl(m)"; };
+struct IasCol : TableColumn<double> { static constexpr std::string_view name = "Ias(m/s)"; };
+struct CmdTimeCol : TableColumn<double, ColumnAlign::Center, 12, 3> { static constexpr std::string_view name = "Time(s)"; };
+struct CmdCol : TableColumn<double, ColumnAlign::Left, 12, 3> { static constexpr std::string_view name = "Cmd"; };
+struct ErrCol : TableColumn<double, ColumnAlign::Left, 12, 3> { static constexpr std::string_view name = "Err"; };
+using FlightTable = TelemetryTable<TimeCol, AglCol, IasCol>;
+using ControlTable = TelemetryTable<CmdTimeCol, CmdCol, ErrCol>;
+
+/// @brief Longest a Ctrl-C waits for queued output, and then for the log
+constexpr std::chrono::milliseconds kShutdownTimeout{500};
+
+/// @brief Ctrl-C, kill and hangup: the handler only wakes the watcher
+/// thread, which stops the console within kShutdownTimeout, closes the
+/// recorder, restores the terminal, flushes the system log and exits.
+/// Every step is bounded, a render stuck on the terminal cannot keep the
+/// process alive
+std::unique_ptr<SignalWatcher> ExitOnSignal(ThreadManager& tm, ConsoleTablePrinter& printer,
+                                            SystemLog& system_log, std::function<void()> at_exit)
+{
+    return std::make_unique<SignalWatcher>(std::vector<int>{SIGINT, SIGTERM, SIGHUP},
+        [&tm, &printer, &system_log, at_exit = std::move(at_exit)](int signo) {
+            ShutdownStats stats = tm.Shutdown(kShutdownTimeout);
+            // a task still running holds the frame lock, give up on it in time
+            auto deadline = std::chrono::steady_clock::now() + kShutdownTimeout;
+            if (stats.drained)
+                printer.shutdown();
+            else if (!printer.shutdown(deadline))
+                system_log.logger()->warn("console,shutdown,\"render stuck, recorder not flushed\"");
+            if (!stats.drained)
+                system_log.logger()->warn("console,shutdown,\"{} of {} queued tasks dropped\"",
+                                          stats.dropped, stats.queued);
+            system_log.Flush(kShutdownTimeout);
+            if (at_exit)
+                at_exit();
+            std::_Exit(128 + signo);
+        });
+}
+
+/// @brief --replay mode: plays a recorded flight log through the console
+int Replay(ConsoleTablePrinter& printer, SystemLog& system_log, const std::string& prefix,
+           const FlightReplay::Options& options, std::function<void()> at_exit)
+{
+    FlightLog log;
+    if (!log.Open(prefix)){
+        std::cerr << "no flight log found at " << prefix << ".0000.ccrec\n";
+        return 1;
+    }
+    // every recorded sample is replayed, posters wait rather than drop
+    QueueLimits limits;
+    limits.telemetry = TelemetryOverflow::Wait;
+    auto tm = ThreadManager(ExecutorKind::LockFree, ConsoleRefresh{}, std::move(limits));
+    tm.WatchResize(printer);
+    auto exit_on_signal = ExitOnSignal(tm, printer, system_log, std::move(at_exit));
+    tm.PostStatus(printer, {ConsoleLevels::INFO, "Replay",
+        fmt::format("{} ({:.1f} MB, {:.1f} s)", prefix, log.bytes() / 1e6,
+                    (log.end_ns() - log.start_ns()) / 1e9)});
+
+    FlightReplay replay(log);
+    auto stats = replay.Run(tm, printer, options);
+    tm.PostStatus(printer, {ConsoleLevels::INFO, "Replay",
+        fmt::format("{} samples, {} statuses in {:.2f} s ({:.0f} samples/s)",
+                    stats.samples, stats.statuses, stats.wall_s,
+                    stats.wall_s > 0 ? stats.samples / stats.wall_s : 0.0)});
+    return 0;
+}
+
+int main(int argc, char** argv)
 {
+    // --record <prefix>: keep every sample in <prefix>.NNNN.ccrec segments
+    // --replay <prefix> [--speed <N>|max] [--seek <seconds>]: play one back
+    // --verbose: draw VINFO statuses too, they always go to system_log.csv
+    // --log-telemetry: log every table row to system_log.csv as well
+    // --shm <name>: draw nothing, publish to clean_console_view --shm <name>
+    // --footer: draw console latency and throughput under the tables
+    // --metrics <path>: write the same counters as CSV on exit
+    // --format-threads <N>: format big frames on N threads, the console thread included
+    std::string record_prefix;
+    std::string replay_prefix;
+    std::string shm_name;
+    std::string metrics_path;
+    FlightReplay::Options replay_options;
+    bool verbose = false;
+    bool footer = false;
+    bool log_telemetry = false;
+    size_t format_threads = 1;
+    for (int i = 1; i < argc; ++i){
+        if (std::strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+        else if (std::strcmp(argv[i], "--footer") == 0)
+            footer = true;
+        else if (std::strcmp(argv[i], "--log-telemetry") == 0)
+            log_telemetry = true;
+        else if (i + 1 == argc)
+            break;
+        else if (std::strcmp(argv[i], "--record") == 0)
+            record_prefix = argv[++i];
+        else if (std::strcmp(argv[i], "--replay") == 0)
+            replay_prefix = argv[++i];
+        else if (std::strcmp(argv[i], "--speed") == 0){
+            ++i;
+            replay_options.speed = std::strcmp(argv[i], "max") == 0 ? 0.0 : std::atof(argv[i]);
+        }
+        else if (std::strcmp(argv[i], "--seek") == 0)
+            replay_options.seek_s = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--shm") == 0)
+            shm_name = argv[++i];
+        else if (std::strcmp(argv[i], "--metrics") == 0)
+            metrics_path = argv[++i];
+        else if (std::strcmp(argv[i], "--format-threads") == 0)
+            format_threads = static_cast<size_t>(std::max(std::atoi(argv[++i]), 1));
+    }
+    auto dump_metrics = [&metrics_path] {
+        if (!metrics_path.empty() && !instrument::Dump(instrument::Read(), metrics_path))
+            std::cerr << "cannot write metrics to " << metrics_path << "\n";
+    };
+
+    // file I/O happens on the log's own thread, never on the console thread
+    SystemLog system_log(SystemLog::Options{});
+
+    ConsoleTablePrinter printer(system_log.logger(), 12, 5);
+    printer.setVerbose(verbose);
+    printer.setFooter(footer);
+    printer.setLogTelemetry(log_telemetry);
+    printer.setFormatThreads(format_threads);
+    if (!record_prefix.empty()){
+        FlightRecorder::Options options{record_prefix};
+        options.logger = system_log.logger();
+        printer.attachRecorder(std::make_shared<FlightRecorder>(std::move(options)));
+    }
 
-    auto logger = spdlog::stdout_color_mt("console");
-    logger->set_pattern("%v");
+    // a viewer process renders instead, the sim never waits for it
+    std::unique_ptr<ShmConsole> shm;
+    if (!shm_name.empty()){
+        shm = std::make_unique<ShmConsole>(shm_name);
+        if (!shm->ok()){
+            std::cerr << "cannot create shared memory ring /" << shm_name << "\n";
+            return 1;
+        }
+    }
+    IConsole& console = shm ? static_cast<IConsole&>(*shm) : printer;
+
+    // the controller pane sits next to the flight table, redrawn at 2 Hz
+    printer.setPaneLayout(PaneLayout::SideBySide);
+    TableId controller = console.addTable({"controller", 5, 2.0});
 
-    ConsoleTablePrinter printer(logger, 12, 5);
-    // std::signal(SIGINT, printer.SignalHandler);
+    if (!shm)
+        printer.print_banner("v1.2.3", "1/13/2026 @ 10:42");
+    if (!replay_prefix.empty()){
+        int status = Replay(printer, system_log, replay_prefix, replay_options, dump_metrics);
+        dump_metrics();
+        return status;
+    }
 
-    auto tm = ThreadManager();
+    // registered before the render thread exists: with --shm the ring has a
+    // single publisher, which is the executor from here on
+    FlightTable flight(console);
+    ControlTable control(console, controller);
+
+    // a stalled terminal sheds the rows posted while the ring is full (the
+    // lock-free ring cannot drop queued ones), the log says when it starts
+    QueueLimits limits;
+    limits.telemetry = TelemetryOverflow::DropNewest;
+    limits.on_high_water = [logger = system_log.logger()](const QueueStats& stats) {
+        logger->warn("queue,high water,\"{} queued, {} dropped\"", stats.depth, stats.dropped);
+    };
+    auto tm = ThreadManager(ExecutorKind::LockFree, ConsoleRefresh{}, std::move(limits));
+    tm.WatchResize(console);
+    auto exit_on_signal = ExitOnSignal(tm, printer, system_log, dump_metrics);
 
     // -----------------------------
     // Static lines (printed once)
     // -----------------------------
-    printer.print_banner("v1.2.3", "1/13/2026 @ 10:42");
-    tm.PostStatus(printer, {ConsoleLevels::VINFO, "INIT", "Initializing application"});
-    tm.PostStatus(printer, {ConsoleLevels::INFO, "Console", "Starting Application"});
-    tm.PostStatus(printer, {ConsoleLevels::WARN, "Sixdof", "Starting simulation"});
-    tm.PostStatus(printer, {ConsoleLevels::ERROR, "Controller", "not running simulation"});
+    tm.BeginBatch(console)
+        .Status({ConsoleLevels::VINFO, "INIT", "Initializing application"})
+        .Status({ConsoleLevels::INFO, "Console", "Starting Application"})
+        .Status({ConsoleLevels::WARN, "Sixdof", "Starting simulation"})
+        .Status({ConsoleLevels::ERROR, "Controller", "not running simulation"});
 
     std::vector<Column> header = {
         {"Time(s)", ColumnAlign::Center},
@@ -41,31 +209,43 @@ int main()
     };
 
     for (double i=0; i < 6; ++i){
-        auto data = printer.convert_data({i,i,i});
-        tm.PostTelem(printer, {header, data});
+        auto data = console.convert_data({i,i,i});
+        tm.PostTelem(console, {header, data});
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
     }
 
-    tm.PostStatus(printer, {ConsoleLevels::INFO, "Console", "running application"});
+    tm.PostStatus(console, {ConsoleLevels::INFO, "Console", "running application"});
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
 
     for (double i=6; i < 8; ++i){
-        auto data = printer.convert_data({i,i,i});
-        tm.PostTelem(printer, {header, data});
+        tm.PostSample(console, flight.Sample(i, i, i));
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
     }
 
     size_t ex = 0;
-    tm.PollStatus(printer, {ConsoleLevels::INFO, "Server", "connecting to client"}, [&ex](size_t id) {
+    tm.PollStatus(console, {ConsoleLevels::INFO, "Server", "connecting to client"}, [&ex](size_t id) {
         ex = id;
     });
 
     for (double i=8; i < 80; ++i){
-        auto data = printer.convert_data({i,i,i});
-        tm.PostTelem(printer, {header, data});
+        // both panes of a step land in the same frame
+        auto step = tm.BeginBatch(console);
+        step.Sample(flight.Sample(i, i, i))
+            .Sample(control.Sample(i, i * 0.5, 1.0 / i));
+        step.Commit();
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
     }
-    tm.HaultPolledStatus(printer, ex, {ConsoleLevels::INFO, "Server", "connecting to client --completed"});
-    tm.PostStatus(printer, {ConsoleLevels::ERROR, "debugger", "client issues"});
+    tm.HaultPolledStatus(console, ex, {ConsoleLevels::INFO, "Server", "connecting to client --completed"});
+    tm.PostStatus(console, {ConsoleLevels::ERROR, "debugger", "client issues"});
+    tm.PostStatus(console, {ConsoleLevels::VINFO, "Console",
+        fmt::format("{} telemetry samples coalesced", tm.CoalescedSamples())});
+    QueueStats queue = tm.ExecutorStats();
+    tm.PostStatus(console, {ConsoleLevels::VINFO, "Console",
+        fmt::format("queue max depth {}, max latency {:.2f} ms, {} dropped", queue.max_depth,
+                    queue.max_latency.count() / 1e6, queue.dropped)});
+    if (shm)
+        tm.PostStatus(console, {ConsoleLevels::INFO, "Console",
+            fmt::format("{} messages published, {} dropped by viewers", shm->published(), shm->viewerDrops())});
     std::this_thread::sleep_for(std::chrono::milliseconds(10000));
+    dump_metrics();
 }
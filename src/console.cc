@@ -1,8 +1,89 @@
 #include "console.h"
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <string>
+#include "system_log.h"
 
-void ConsoleTablePrinter::PrintStatusLine(const IStatusPrint& status)
+const char* ConsoleTablePrinter::LevelName(ConsoleLevels level)
+{
+    switch (level)
+    {
+        case VINFO: return "VINFO";
+        case INFO:  return "INFO";
+        case WARN:  return "WARN";
+        case ERROR: return "ERROR";
+    }
+    return "VINFO";
+}
+
+void ConsoleTablePrinter::LogStatus(const IStatusPrint& status) const
+{
+    if (!logger_)
+        return;
+    // VINFO is the verbose level, it logs as debug to stay distinguishable
+    spdlog::level::level_enum level = spdlog::level::info;
+    if (status.level == VINFO) level = spdlog::level::debug;
+    if (status.level == WARN) level = spdlog::level::warn;
+    if (status.level == ERROR) level = spdlog::level::err;
+    if (!logger_->should_log(level))
+        return;
+    // source,header,message (time and level come from the logger pattern)
+    fmt::memory_buffer line;
+    fmt::format_to(std::back_inserter(line), "status,");
+    AppendCsvField(line, status.header.view());
+    line.push_back(',');
+    AppendCsvField(line, status.data.view());
+    logger_->log(level, std::string_view(line.data(), line.size()));
+}
+
+void ConsoleTablePrinter::LogSample(const TelemetrySample& sample, const std::vector<std::string>* text) const
+{
+    if (!log_telemetry_ || !logger_ || !logger_->should_log(spdlog::level::debug))
+        return;
+    // the row is a CSV record of its own, quoted as one message field
+    fmt::memory_buffer row;
+    for (size_t c = 0; c < sample.count; ++c){
+        if (c > 0) row.push_back(',');
+        if (text)
+            AppendCsvField(row, (*text)[c]);
+        else if (sample.is_int(c))
+            fmt::format_to(std::back_inserter(row), "{}", sample.values[c].i);
+        else
+            fmt::format_to(std::back_inserter(row), "{}", sample.values[c].f);
+    }
+    fmt::memory_buffer line;
+    fmt::format_to(std::back_inserter(line), "telemetry,schema{},", sample.schema);
+    AppendCsvField(line, std::string_view(row.data(), row.size()));
+    logger_->debug(std::string_view(line.data(), line.size()));
+}
+
+SchemaHandle ConsoleTablePrinter::registerSchema(std::vector<Column> columns, int precision)
+{
+    return registerStaticSchema(std::move(columns), precision, {});
+}
+
+SchemaHandle ConsoleTablePrinter::registerStaticSchema(std::vector<Column> columns, int precision,
+                                                       const StaticLayout& layout)
+{
+    SchemaHandle handle = schemas_.Register(columns, precision, layout);
+    if (logger_){
+        // describes the telemetry lines logged with this handle, the
+        // titles are a CSV record quoted as one message field
+        fmt::memory_buffer titles;
+        for (size_t c = 0; c < columns.size(); ++c){
+            if (c > 0) titles.push_back(',');
+            AppendCsvField(titles, columns[c].title);
+        }
+        fmt::memory_buffer line;
+        fmt::format_to(std::back_inserter(line), "schema,schema{},", handle);
+        AppendCsvField(line, std::string_view(titles.data(), titles.size()));
+        logger_->info(std::string_view(line.data(), line.size()));
+    }
+    return handle;
+}
+
+void ConsoleTablePrinter::FormatStatusLine(const IStatusPrint& status, std::string& out) const
 {
     // ANSI color codes
     constexpr const char* COLOR_RESET  = "\033[0m";
@@ -11,154 +92,635 @@ void ConsoleTablePrinter::PrintStatusLine(const IStatusPrint& status)
     constexpr const char* COLOR_GREEN  = "\033[32m";
     constexpr const char* COLOR_BLUE   = "\033[34m";
     const char* color = COLOR_RESET;
-    const char* level_str = "VINFO";
+    const char* level_str = LevelName(status.level);
     switch (status.level)
     {
-        case VINFO: color = COLOR_BLUE;   level_str = "VINFO"; break;
-        case INFO:  color = COLOR_GREEN;  level_str = "INFO";  break;
-        case WARN:  color = COLOR_YELLOW; level_str = "WARN";  break;
-        case ERROR: color = COLOR_RED;    level_str = "ERROR"; break;
+        case VINFO: color = COLOR_BLUE;   break;
+        case INFO:  color = COLOR_GREEN;  break;
+        case WARN:  color = COLOR_YELLOW; break;
+        case ERROR: color = COLOR_RED;    break;
     }
-    std::cout << "\033[K"; // clear line
     // Format: [<level>][<location>] <data> - where the level is also color coded
-    std::cout << color << "[" << level_str << "]" << COLOR_RESET
-              << "[" << status.header << "] "
-              << status.data
-              << std::endl;
-}
-
-size_t ConsoleTablePrinter::newStatus(const IStatusPrint status){
-    // 1. Move cursor to end of the status rows
-    auto move = (current_displayed_table_rows_ > 0) ? current_displayed_table_rows_+3 : 0;
-    MoveCursorUp(move);
-    // 2. update and print status on bottom of status rows
-    status_rows_.push_back(status);
-    PrintStatusLine(status);
-    // 3. update and redraw the table
-    table_start_++;
-    printTelemTable(true);
-    return (size_t)status_rows_.size()-1;
-}
-
-size_t ConsoleTablePrinter::updateStatus(size_t index, const IStatusPrint status){
-    // 1. Move cursor to status row commanded from index
-    size_t total_rows = 0;
-    if (current_displayed_table_rows_ > 0){
-            total_rows = total_rows + current_displayed_table_rows_ + 3;
-    }
-    total_rows= total_rows+(size_t)status_rows_.size()-index;
-    MoveCursorUp(total_rows);
-    // 2. update and print new status into that status row
-    PrintStatusLine(status);
-    status_rows_[index] = status;
-    std::cout << "\033[999;1H";  // move to bottom
+    fmt::format_to(std::back_inserter(out), "{}[{}]{}[{}] {}",
+                   color, level_str, COLOR_RESET, status.header.view(), status.data.view());
+}
+
+size_t ConsoleTablePrinter::newStatus(const IStatusPrint& status){
+    return AppendStatus(status, flight_log::kStatusNew);
+}
+
+size_t ConsoleTablePrinter::AppendStatus(const IStatusPrint& status, flight_log::StatusEvent event){
+    LogStatus(status);
+    std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+    // VINFO only reaches system_log.csv unless in verbose mode
+    if (status.level == VINFO && !verbose_)
+        return kHiddenStatusId;
+    size_t id = status_rows_.Push(status);
+    if (recorder_){
+        IStatusPrint recorded = status;
+        recorded.id = id;
+        recorder_->RecordStatus(event, recorded, FlightRecorder::Now());
+    }
+    return id;
+}
+
+size_t ConsoleTablePrinter::updateStatus(size_t index, const IStatusPrint& status){
+    std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+    // ids that scrolled out of the history are dropped silently
+    if (IStatusPrint* row = status_rows_.Find(index)){
+        *row = status;
+        row->id = index;
+    }
     return index;
 }
 
+ConsoleTablePrinter::TelemetryRow& ConsoleTablePrinter::NextRow(Table& table){
+    // a full ring rotates in O(1), the oldest slot becomes the newest
+    if (table.rows.full())
+        table.rows.rotate(table.rows.begin() + 1);
+    else
+        table.rows.push_back(TelemetryRow{});
+    table.dirty = true;
+    return table.rows.back();
+}
+
+ConsoleTablePrinter::Table& ConsoleTablePrinter::TableFor(TableId id){
+    return id < tables_.size() ? tables_[id] : tables_[kDefaultTable];
+}
+
+TableId ConsoleTablePrinter::addTable(const TableOptions& options){
+    std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+    tables_.emplace_back(options);
+    return static_cast<TableId>(tables_.size() - 1);
+}
+
 bool ConsoleTablePrinter::addTelemetry(const ITelemetryPrint telem){
-    table_rows_.push_back(telem);
-    return table_rows_.size() < 2;
+    TelemetrySample sample;
+    sample.schema = schemas_.Intern(telem.columns);
+    sample.count = static_cast<uint32_t>(std::min(telem.data.size(), kMaxTelemetryColumns));
+    sample.table = telem.table;
+
+    std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+    Table& table = TableFor(sample.table);
+    // the log and the window statistics are numeric, text cells are
+    // parsed back into doubles only when one of them needs it
+    if (recorder_ || table.windowed())
+        for (size_t c = 0; c < sample.count; ++c)
+            sample.values[c].f = std::strtod(telem.data[c].c_str(), nullptr);
+    AppendRow(table, sample, &telem.data);
+    return false;
+}
+
+bool ConsoleTablePrinter::addSample(const TelemetrySample& sample){
+    std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+    AppendRow(TableFor(sample.table), sample, nullptr);
+    return false;
+}
+
+void ConsoleTablePrinter::AppendRow(Table& table, const TelemetrySample& sample,
+                                    const std::vector<std::string>* text){
+    // a new header is diffed like any other line, only a resize repaints all
+    bool new_layout = table.rows.empty() || table.rows.back().sample.schema != sample.schema;
+    if (table.windowed()){
+        AggregateRow(table, sample, new_layout);
+    } else {
+        TelemetryRow& row = NextRow(table);
+        row.sample = sample;
+        if (text)
+            row.text = *text;
+        else
+            row.text.clear();
+    }
+    if (recorder_)
+        recorder_->RecordSample(sample, schemas_.Get(sample.schema), FlightRecorder::Now());
+    LogSample(sample, text);
+}
+
+void ConsoleTablePrinter::AggregateRow(Table& table, const TelemetrySample& sample, bool new_layout){
+    // windows are tumbling: the newest row is the open window and updates
+    // with every sample, closed windows scroll up like raw rows would
+    // samples carry no producer time: window_s and Rate go by the time the
+    // sample is applied here, so queueing delay shows up as rate jitter
+    auto now = std::chrono::steady_clock::now();
+    bool open = table.window.count() > 0 && !new_layout &&
+                (table.window_time == std::chrono::steady_clock::duration::zero() ||
+                 now - table.window_start < table.window_time);
+    if (!open){
+        NextRow(table);
+        table.window.Reset();
+        table.window_start = now;
+    }
+    table.window.Add(sample, std::chrono::duration<double>(now.time_since_epoch()).count());
+
+    TelemetryRow& row = table.rows.back();
+    row.text.clear();
+    row.sample.schema = sample.schema;
+    row.sample.table = sample.table;
+    table.window.Summarize(schemas_.Get(sample.schema).columns, row.sample);
+    table.dirty = true;
+
+    // a full sample window closes now, the next sample opens a new row
+    if (table.window_samples > 0 && table.window.count() >= table.window_samples)
+        table.window.Reset();
 }
 
 void ConsoleTablePrinter::printTelemTable(bool full_redraw)
 {
-    if (table_rows_.empty())
+    std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+    Render(full_redraw);
+}
+
+void ConsoleTablePrinter::Render(bool full_redraw)
+{
+    instrument::Stopwatch render_time;
+    if (full_redraw)
+        compositor_.Invalidate();
+
+    // tables first, their height decides how many statuses fit
+    // only tables whose rows changed are formatted again, the others
+    // reuse their lines and the compositor sends nothing for them
+    FitPanes();
+    auto now = std::chrono::steady_clock::now();
+    format_jobs_.clear();
+    format_rows_ = 0;
+    bool titled = false;
+    for (auto& table : tables_){
+        BuildTable(table, now);
+        titled |= table.line_count > 0 && !table.name.empty();
+    }
+    // untitled panes start one line lower so the headers line up
+    auto skip = [titled](const Table& table){ return (titled && table.name.empty()) ? 1u : 0u; };
+    size_t height = 0;
+    for (const auto& table : tables_){
+        if (pane_layout_ == PaneLayout::Stacked)
+            height += table.line_count;
+        else if (table.line_count > 0)
+            height = std::max(height, table.line_count + skip(table));
+    }
+
+    // the cursor cannot climb above the screen: the frame stays below the
+    // last row by dropping the oldest statuses
+    size_t status_room = SIZE_MAX;
+    if (terminal_.rows > 0){
+        size_t fixed = height + (footer_ ? 1 : 0) + 1;
+        status_room = terminal_.rows > fixed ? terminal_.rows - fixed : 0;
+    }
+
+    visible_statuses_.clear();
+    status_rows_.ForEachVisible([this](const IStatusPrint& status){
+        visible_statuses_.push_back(&status);
+    }, status_room);
+    // a taller status window (terminal grew, tables shrank) shows older rows
+    size_t first_drawn = status_rows_.first_visible_id(status_room);
+    if (first_drawn < first_drawn_status_)
+        UnparkSpinners(first_drawn);
+    first_drawn_status_ = first_drawn;
+    if (status_lines_.size() < visible_statuses_.size())
+        status_lines_.resize(visible_statuses_.size());
+    for (size_t first = 0; first < visible_statuses_.size(); first += kRowsPerJob)
+        format_jobs_.push_back({nullptr, first, std::min(kRowsPerJob, visible_statuses_.size() - first)});
+    format_rows_ += visible_statuses_.size();
+    // every line is formatted before the frame is composed, in any order
+    // and on any thread: each job owns the lines it writes
+    RunFormatJobs();
+
+    compositor_.BeginFrame();
+    for (size_t i = 0; i < visible_statuses_.size(); ++i)
+        std::swap(compositor_.NextLine(), status_lines_[i]);
+
+    if (pane_layout_ == PaneLayout::Stacked){
+        for (const auto& table : tables_)
+            for (size_t i = 0; i < table.line_count; ++i){
+                std::string& line = compositor_.NextLine();
+                line = table.lines[i];
+                ClipToWidth(line, terminal_.columns);
+            }
+    } else {
+        for (size_t i = 0; i < height; ++i){
+            std::string& line = compositor_.NextLine();
+            bool first = true;
+            for (const auto& table : tables_){
+                if (table.line_count == 0)
+                    continue;
+                if (!first)
+                    line.append(kPaneGap, ' ');
+                first = false;
+                size_t start = line.size();
+                size_t row = i - skip(table);
+                if (i >= skip(table) && row < table.line_count)
+                    line += table.lines[row];
+                line.resize(start + table.width, ' ');
+            }
+            // no trailing blanks, they would only be diffed and sent
+            line.erase(line.find_last_not_of(' ') + 1);
+            ClipToWidth(line, terminal_.columns);
+        }
+    }
+
+    if (footer_){
+        if (now - footer_at_ >= kFooterPeriod){
+            instrument::Snapshot snapshot = instrument::Read();
+            footer_text_.clear();
+            instrument::AppendFooter(snapshot, footer_prev_, footer_text_);
+            footer_prev_ = snapshot;
+            footer_at_ = now;
+        }
+        std::string& line = compositor_.NextLine();
+        line = footer_text_;
+        ClipToWidth(line, terminal_.columns);
+    }
+
+    const FrameStats& stats = compositor_.Flush();
+    instrument::Count(instrument::kFrames);
+    instrument::Record(instrument::kFrameBytes, stats.bytes);
+    instrument::Record(instrument::kRenderNs, render_time.ElapsedNs());
+}
+
+bool ConsoleTablePrinter::terminalResized()
+{
+    std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+    TerminalSize size = compositor_.size();
+    if (size.columns == 0)
+        return false; // not a terminal, nothing to fit
+    terminal_ = size;
+    // the terminal may have rewrapped what it showed, repaint all of it
+    return true;
+}
+
+void ConsoleTablePrinter::scrollColumns(TableId id, size_t first_column)
+{
+    std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+    Table& table = TableFor(id);
+    if (table.first_column == first_column)
+        return;
+    table.first_column = first_column;
+    table.dirty = true;
+}
+
+void ConsoleTablePrinter::FitPanes()
+{
+    size_t panes = 0;
+    for (const auto& table : tables_)
+        panes += table.rows.empty() ? 0 : 1;
+    size_t budget = terminal_.columns;
+    if (budget > 0 && pane_layout_ == PaneLayout::SideBySide && panes > 1){
+        size_t gaps = kPaneGap * (panes - 1);
+        budget = budget > gaps + panes ? (budget - gaps) / panes : 1;
+    }
+    for (auto& table : tables_){
+        if (table.budget == budget)
+            continue;
+        table.budget = budget;
+        // rebuilt in this frame, a refresh cap does not hold back a resize
+        table.dirty = true;
+        table.built = {};
+    }
+}
+
+void ConsoleTablePrinter::ClipToWidth(std::string& line, size_t columns)
+{
+    if (columns == 0 || line.size() <= columns)
+        return; // fewer bytes than cells always fits
+    size_t cells = 0;
+    bool styled = false;
+    for (size_t i = 0; i < line.size(); ++i){
+        auto ch = static_cast<unsigned char>(line[i]);
+        if (ch == '\033'){
+            // CSI escapes (colors) take no cell: ESC [ params final
+            styled = true;
+            if (i + 1 < line.size() && line[i + 1] == '['){
+                i += 2;
+                while (i < line.size() && (line[i] < 0x40 || line[i] > 0x7e))
+                    ++i;
+            }
+            continue;
+        }
+        if ((ch & 0xC0) == 0x80)
+            continue; // UTF-8 continuation byte, same cell
+        if (cells == columns){
+            line.resize(i);
+            if (styled)
+                line += "\033[0m";
+            return;
+        }
+        ++cells;
+    }
+}
+
+bool ConsoleTablePrinter::TablesDue(std::chrono::steady_clock::time_point now) const
+{
+    for (const auto& table : tables_)
+        if (table.dirty && now - table.built >= table.interval)
+            return true;
+    return false;
+}
+
+void ConsoleTablePrinter::BuildTable(Table& table, std::chrono::steady_clock::time_point now)
+{
+    if (!table.dirty || now - table.built < table.interval)
+        return;
+    table.dirty = false;
+    table.built = now;
+    table.line_count = 0;
+    table.width = 0;
+    if (table.rows.empty())
         return;
 
     // Latest telemetry for header layout
-    const ITelemetryPrint& telem = table_rows_.back();
-    std::string h_fmt = BuildFormat(telem.columns);
-    auto header_args = BuildArgs(telem.columns);
-    std::string header_line = fmt::vformat(h_fmt, header_args);
-    size_t total_width = telem.columns.size() * column_width_;
+    SchemaHandle handle = table.rows.back().sample.schema;
+    table.schema = handle;
+    table.precision = schemas_.Get(handle).precision;
+    FormatHeader(Layout(handle), table);
 
-    if (full_redraw)
-    {
-        // Print header + separators
-        PrintRow(std::string(total_width, '='));
-        PrintRow(header_line);
-        PrintRow(std::string(total_width, '='));
+    // row lines exist before any job writes to them
+    while (table.lines.size() < table.line_count + table.rows.size())
+        table.lines.emplace_back();
+    table.line_count += table.rows.size();
+    for (size_t first = 0; first < table.rows.size(); first += kRowsPerJob)
+        format_jobs_.push_back({&table, first, std::min(kRowsPerJob, table.rows.size() - first)});
+    format_rows_ += table.rows.size();
+}
+
+void ConsoleTablePrinter::RunFormatJobs()
+{
+    if (format_pool_ && format_rows_ >= kParallelRows){
+        format_pool_->Run(format_jobs_.size(), [this](size_t job){ RunFormatJob(format_jobs_[job]); });
+        ++pooled_frames_;
+        return;
     }
-    else
-    {
-        // Move cursor to the start of the data area
-        MoveCursorUp(static_cast<int>(current_displayed_table_rows_));
+    for (const FormatJob& job : format_jobs_)
+        RunFormatJob(job);
+}
+
+void ConsoleTablePrinter::RunFormatJob(const FormatJob& job)
+{
+    if (job.table){
+        FormatRows(*job.table, job.first, job.count);
+        return;
     }
+    for (size_t i = job.first; i < job.first + job.count; ++i){
+        std::string& line = status_lines_[i];
+        line.clear();
+        FormatStatusLine(*visible_statuses_[i], line);
+        ClipToWidth(line, terminal_.columns);
+    }
+}
 
-    // Print newest rows (circular buffer ensures we only have max rows)
-    for (const auto& row : table_rows_)  // oldest → newest
-    {
-        fmt::dynamic_format_arg_store<fmt::format_context> store;
-        store.push_back(column_width_);  // {0} = column width
+std::string& ConsoleTablePrinter::TableLine(Table& table)
+{
+    if (table.line_count == table.lines.size())
+        table.lines.emplace_back();
+    std::string& line = table.lines[table.line_count++];
+    line.clear();
+    return line;
+}
 
-        for (const auto& cell : row.data)
-            store.push_back(cell);
+const ConsoleTablePrinter::TableLayout& ConsoleTablePrinter::Layout(SchemaHandle handle)
+{
+    if (handle >= layouts_.size())
+        layouts_.resize(handle + 1);
+    TableLayout& layout = layouts_[handle];
+    if (layout.valid)
+        return layout;
 
-        std::string line = fmt::vformat(h_fmt, store);
-        PrintRow(line);
+    const TelemetrySchema& schema = schemas_.Get(handle);
+    const StaticLayout& fixed = schema.layout;
+    bool typed = fixed.format != nullptr && fixed.widths != nullptr;
+    size_t columns = schema.columns.size();
+    layout.schema = handle;
+    layout.format = typed ? fixed.format : nullptr;
+    layout.format_cell = typed ? fixed.format_cell : nullptr;
+    layout.offsets.clear();
+    layout.widths.clear();
+    layout.aligns.clear();
+    size_t offset = 1; // skip the leading '['
+    for (size_t c = 0; c < columns; ++c){
+        size_t width = typed ? fixed.widths[c] : static_cast<size_t>(column_width_);
+        layout.offsets.push_back(offset);
+        layout.widths.push_back(width);
+        layout.aligns.push_back(schema.columns[c].align);
+        offset += width;
+    }
+    layout.width = offset - 1;
+    if (typed){
+        // built at compile time by TelemetryTable
+        layout.separator = fixed.separator;
+        layout.header = fixed.header;
+        layout.blank_row = fixed.blank_row;
+    } else {
+        layout.separator = "[" + std::string(layout.width, '=') + "]";
+        layout.blank_row = "[" + std::string(layout.width, ' ') + "]";
+        layout.header = layout.blank_row;
+        for (size_t c = 0; c < columns; ++c){
+            const std::string& title = schema.columns[c].title;
+            PlaceCell(layout.header, layout.offsets[c], layout.widths[c], layout.aligns[c], title.data(), title.size());
+        }
     }
+    layout.valid = true;
+    return layout;
+}
 
-    current_displayed_table_rows_ = table_rows_.size();
+void ConsoleTablePrinter::PlaceCell(std::string& line, size_t offset, size_t width, ColumnAlign align,
+                                    const char* text, size_t len)
+{
+    len = std::min(len, width);
+    // centered text keeps the extra space on the right, like fmt's '^'
+    size_t pad = (align == ColumnAlign::Center) ? (width - len) / 2 : 0;
+    line.replace(offset + pad, len, text, len);
 }
 
-// Starts polling a status asynchronously, returns a unique id
-size_t ConsoleTablePrinter::startPolling(const IStatusPrint status) {
-    auto id = newStatus(status);
-    int interval_ms = 200;
+size_t ConsoleTablePrinter::FormatCell(const TelemetrySample& sample, size_t n,
+                                       int precision, char* buf, size_t size) const
+{
+    size_t len = sample.is_int(n) ? fast_format::FormatInt(sample.values[n].i, buf, size)
+                                  : fast_format::FormatFixed(precision, sample.values[n].f, buf, size);
+    return std::min(len, size);
+}
+
+void ConsoleTablePrinter::FormatHeader(const TableLayout& layout, Table& table)
+{
+    // the columns that fit the pane, from the one scrolled to; brackets
+    // turn into '<' / '>' on a side with hidden columns
+    size_t columns = layout.offsets.size();
+    size_t first = std::min(table.first_column, columns > 0 ? columns - 1 : 0);
+    size_t begin = columns > 0 ? layout.offsets[first] : 1;
+    size_t room = table.budget == 0 ? SIZE_MAX : std::max<size_t>(table.budget, 3) - 2;
+    size_t last = first;
+    while (last < columns && layout.offsets[last] + layout.widths[last] - begin <= room)
+        ++last;
+    if (last == first && columns > 0)
+        last = first + 1; // wider than the pane, cut with the frame
+    table.first = first;
+    table.last = last;
+    table.begin = begin;
+    table.end = columns > 0 ? layout.offsets[last - 1] + layout.widths[last - 1] : begin;
 
-    // Stop flag for this poll
-    auto stop_flag = std::make_shared<std::atomic<bool>>(false);
+    // Title (named tables only), header + separators
+    if (!table.name.empty())
+        TableLine(table).append(" ").append(table.name);
+    FrameLine(layout, table, layout.separator, TableLine(table));
+    FrameLine(layout, table, layout.header, TableLine(table));
+    FrameLine(layout, table, layout.separator, TableLine(table));
+    table.width = std::max(table.lines[table.line_count - 1].size(), table.name.size() + 1);
+    table.header_lines = table.line_count;
+}
 
-    // Launch thread
-    u_int8_t frame=0;
-    std::thread t([this, id, frame, status, stop_flag, interval_ms]() {
-        auto local_frame = frame;
-        while (!stop_flag->load()) {
-            auto local_status = status;
-            local_status.data += pollingWaveform(local_frame++, 8);
-            updateStatus(id, local_status);
-            std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+void ConsoleTablePrinter::FrameLine(const TableLayout& layout, const Table& table,
+                                    const std::string& full, std::string& line)
+{
+    if (table.first == 0 && table.last == layout.offsets.size()){
+        line = full;
+        return;
+    }
+    line.clear();
+    line.append(1, table.first > 0 ? '<' : '[')
+        .append(full, table.begin, table.end - table.begin)
+        .push_back(table.last < layout.offsets.size() ? '>' : ']');
+}
+
+void ConsoleTablePrinter::FormatRows(Table& table, size_t first, size_t count) const
+{
+    const TableLayout& layout = layouts_[table.schema];
+    bool whole = table.first == 0 && table.last == layout.offsets.size();
+    char buf[64];
+    for (size_t r = first; r < first + count; ++r)  // oldest → newest
+    {
+        const TelemetryRow& row = table.rows[r];
+        std::string& line = table.lines[table.header_lines + r];
+        bool typed = layout.format && row.text.empty() && row.sample.schema == layout.schema;
+        if (typed && whole){
+            line.resize(layout.blank_row.size());
+            layout.format(row.sample, line.data());
+            continue;
         }
-    });
+        // cells land at fixed offsets of a blank row, values are only
+        // turned into text here, for rows and columns that get drawn
+        FrameLine(layout, table, layout.blank_row, line);
+        for (size_t c = table.first; c < table.last; ++c){
+            size_t at = layout.offsets[c] - table.begin + 1;
+            if (c < row.text.size()){
+                const std::string& cell = row.text[c];
+                PlaceCell(line, at, layout.widths[c], layout.aligns[c], cell.data(), cell.size());
+            } else if (row.text.empty() && c < row.sample.count){
+                size_t len = typed && layout.format_cell ? layout.format_cell(row.sample, c, buf)
+                                                         : FormatCell(row.sample, c, table.precision, buf, sizeof(buf));
+                PlaceCell(line, at, layout.widths[c], layout.aligns[c], buf, len);
+            }
+        }
+    }
+}
 
-    // Store thread and flag
-    std::lock_guard<std::mutex> lock(mutex_);
-    threads_[id] = std::move(t);
-    stop_flags_[id] = stop_flag;
+void ConsoleTablePrinter::shutdown()
+{
+    std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+    spinners_.clear();
+    // usually the last reference: flushes the pending blocks and trims the segment
+    recorder_.reset();
+    RestoreConsoleForShell();
+}
 
-    return id;
+bool ConsoleTablePrinter::shutdown(std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock<std::timed_mutex> lock(frame_mutex_, std::defer_lock);
+    if (!lock.try_lock_until(deadline)){
+        // the frame model belongs to the stuck render, only the device is touched
+        compositor_.WriteDirect(kRestoreConsole);
+        return false;
+    }
+    spinners_.clear();
+    recorder_.reset();
+    RestoreConsoleForShell();
+    return true;
 }
 
-// Stops a polling thread given its id
-void ConsoleTablePrinter::stopPolling(size_t id, const IStatusPrint status) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (stop_flags_.count(id)) {
-        stop_flags_[id]->store(true); // signal stop
-        if (threads_[id].joinable())
-            threads_[id].join(); // wait for thread to finish
+// Starts a polling animation on a new status, returns its unique id
+size_t ConsoleTablePrinter::startPolling(const IStatusPrint& status) {
+    auto id = AppendStatus(status, flight_log::kStatusPollStart);
+    if (id == kHiddenStatusId)
+        return id;
 
-        threads_.erase(id);
-        stop_flags_.erase(id);
+    std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+    spinners_[id] = Spinner{status, 0};
+    animation_wheel_.Schedule(id);
+    return id;
+}
+
+// Stops a polling animation given its id, its wheel entry expires lazily
+void ConsoleTablePrinter::stopPolling(size_t id, const IStatusPrint& status) {
+    LogStatus(status);
+    std::unique_lock<std::timed_mutex> lock(frame_mutex_);
+    if (spinners_.erase(id)) {
+        if (recorder_){
+            IStatusPrint recorded = status;
+            recorded.id = id;
+            recorder_->RecordStatus(flight_log::kStatusPollStop, recorded, FlightRecorder::Now());
+        }
+        lock.unlock();
         updateStatus(id, status);
     }
 }
 
-/// @brief Generates a small waveform string for polling animation
+// Advances every due polling animation, the caller redraws once for all
+bool ConsoleTablePrinter::advanceAnimations(std::chrono::steady_clock::time_point now) {
+    std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+    bool redraw_due = TablesDue(now) || (footer_ && now - footer_at_ >= kFooterPeriod);
+    if (animation_wheel_.empty())
+        return redraw_due;
+
+    size_t advanced = 0;
+    animation_wheel_.Advance(now, [&](size_t id) {
+        auto it = spinners_.find(id);
+        if (it == spinners_.end())
+            return; // stopped since it was scheduled
+        IStatusPrint* row = status_rows_.Find(id);
+        if (row == nullptr){
+            spinners_.erase(it); // left the history, nothing to animate
+            return;
+        }
+        Spinner& spinner = it->second;
+        if (id < first_drawn_status_){
+            spinner.parked = true; // redrawing it would not change the screen
+            return;
+        }
+        row->data = spinner.status.data;
+        AppendWaveform(spinner.frame++, 8, row->data);
+        animation_wheel_.Schedule(id);
+        ++advanced;
+    });
+    return advanced > 0 || redraw_due;
+}
+
+void ConsoleTablePrinter::UnparkSpinners(size_t first_drawn) {
+    for (auto it = spinners_.begin(); it != spinners_.end();){
+        Spinner& spinner = it->second;
+        if (!spinner.parked || it->first < first_drawn){
+            ++it;
+        } else if (status_rows_.Find(it->first) == nullptr){
+            it = spinners_.erase(it); // left the history while parked
+        } else {
+            spinner.parked = false;
+            animation_wheel_.Schedule(it->first);
+            ++it;
+        }
+    }
+}
+
+/// @brief Appends a small waveform for the polling animation
 /// @param frame The current frame number (increments every update)
 /// @param width How many blocks to display in the waveform
-/// @return A string like "▁▂▃▄▅▆"
-std::string ConsoleTablePrinter::pollingWaveform(int frame, int width = 8){
-    static const std::vector<std::string> blocks = {
+/// @param out Status text receiving " [▁▂▃▄▅▆]", in place without allocating
+void ConsoleTablePrinter::AppendWaveform(int frame, int width, StatusText& out){
+    static constexpr std::string_view blocks[] = {
         "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█", 
         "▇", "▆", "▅", "▄", "▃", "▁"
     };
-    int n = blocks.size();
-    std::string waveform;
+    constexpr int n = sizeof(blocks) / sizeof(blocks[0]);
 
+    out += " [";
     for (int i = 0; i < width; ++i){
         // Each block is offset by i from the current frame to create motion
         int index = (frame + i) % n;
-        waveform += blocks[index];
+        out += blocks[index];
     }
-    return " [" + waveform + "]";
-}
\ No newline at end of file
+    out += "]";
+}
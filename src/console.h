@@ -3,22 +3,50 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 #include <fmt/format.h>
-#include <fmt/args.h>
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <chrono>
+#include <deque>
 #include <vector>
-#include <chrono>
 #include <mutex>
 #include <atomic>
 #include "console_base.h"
+#include "fast_format.h"
+#include "flight_recorder.h"
+#include "format_pool.h"
+#include "frame_compositor.h"
+#include "instrumentation.h"
+#include "schema_registry.h"
+#include "status_region.h"
+#include "timer_wheel.h"
+#include "window_aggregator.h"
 
 template<typename T>
 std::vector<std::string> convert_to_strings(const std::vector<T>& data, const std::string& fmt_str = "{:.2f}"){
     std::vector<std::string> out;
     out.reserve(data.size());
+    if constexpr (std::is_arithmetic_v<T>){
+        // "{:.Nf}" and "{}" on integers skip fmt's format string parsing,
+        // the short results fit std::string's inline buffer
+        int precision = std::is_floating_point_v<T> ? fast_format::FixedPrecision(fmt_str) : -1;
+        bool plain_int = std::is_integral_v<T> && fmt_str == "{}";
+        if (precision >= 0 || plain_int){
+            char buf[fast_format::kMaxCellChars];
+            for (const auto& val : data){
+                size_t len = plain_int ? fast_format::FormatInt(static_cast<int64_t>(val), buf, sizeof(buf))
+                                       : fast_format::FormatFixed(precision, static_cast<double>(val), buf, sizeof(buf));
+                if (len <= sizeof(buf))
+                    out.emplace_back(buf, len);
+                else
+                    out.push_back(fmt::format(fmt_str, val)); // did not fit, e.g. 1e300
+            }
+            return out;
+        }
+    }
     for (const auto& val : data)
     {
         // Use fmt::format if numeric, fallback to std::to_string for generic types
@@ -30,138 +58,359 @@ std::vector<std::string> convert_to_strings(const std::vector<T>& data, const st
     return out;
 }
 
+/// @brief How several telemetry tables share the area below the statuses
+enum class PaneLayout {
+    Stacked,    /* one table under the other */
+    SideBySide  /* tables next to each other, top aligned */
+};
+
 class ConsoleTablePrinter : public IConsole {
 public:
+    /// @param max_status_rows status lines drawn, older ones scroll out
+    /// @param sink where frames are written, nullptr for OutputSink::Terminal()
+    /// e.g. NullSink for benchmarks, CaptureSink for tests
     ConsoleTablePrinter(std::shared_ptr<spdlog::logger> logger,
                         int width,
-                        size_t max_rows = 12)
+                        size_t max_rows = 12,
+                        size_t max_status_rows = 16,
+                        std::shared_ptr<OutputSink> sink = nullptr)
         : logger_(std::move(logger)),
           column_width_(width),
-          max_table_rows_(max_rows),
-          current_displayed_table_rows_(0),
-          table_rows_(max_table_rows_)
-          {}
+          status_rows_(max_status_rows, kStatusHistoryRows),
+          compositor_(sink ? std::move(sink) : OutputSink::Terminal()),
+          terminal_(compositor_.size())
+          {tables_.emplace_back(TableOptions{"", max_rows});}
 
-    ~ConsoleTablePrinter(){stopAllPolling();RestoreConsoleForShell();}
+    ~ConsoleTablePrinter(){shutdown();}
 
-    inline void SignalHandler(int){
-        stopAllPolling();RestoreConsoleForShell();
-        std::_Exit(0);
-    }
+    /// @brief Last call before exiting: stops the animations, closes the
+    /// recorder (its pending blocks are flushed) and restores the terminal
+    /// Called by the destructor, or once the executor has stopped
+    /// (ThreadManager::Shutdown) on paths that exit without unwinding
+    void shutdown();
+    /// @brief shutdown() for signal and crash paths, waiting for the frame
+    /// lock only until deadline: a render stuck in a blocking write keeps
+    /// it, then the recorder is left as is and the terminal restore is
+    /// written straight to the device
+    /// @return false when the lock could not be taken
+    bool shutdown(std::chrono::steady_clock::time_point deadline);
 
     //****************************************************//
-    size_t newStatus(const IStatusPrint status) override;
+    size_t newStatus(const IStatusPrint& status) override;
     bool addTelemetry(const ITelemetryPrint telem) override;
+    SchemaHandle registerSchema(std::vector<Column> columns, int precision) override;
+    SchemaHandle registerStaticSchema(std::vector<Column> columns, int precision, const StaticLayout& layout) override;
+    TableId addTable(const TableOptions& options) override;
+    bool addSample(const TelemetrySample& sample) override;
     void printTelemTable(bool full_redraw) override;
-    size_t startPolling(const IStatusPrint status) override;
-    void stopPolling(size_t id, const IStatusPrint status) override;
+    bool terminalResized() override;
+    size_t startPolling(const IStatusPrint& status) override;
+    void stopPolling(size_t id, const IStatusPrint& status) override;
+    bool advanceAnimations(std::chrono::steady_clock::time_point now) override;
     inline std::vector<std::string> convert_data(const std::vector<double>& data) override
         {return convert_to_strings(data);}
     //****************************************************//
 
-    inline void print_banner(std::string version, std::string date) {
-        status_start_ = 10; // start printing status messages after the banner
-        std::cout << "=================================================================================================\n";
-        std::cout << "=================================================================================================\n";
-        std::cout << "    ____            __                             _________       __    __     _____ _          \n";
-        std::cout << "   / __ )___  _____/ /_  ____ _____ ___  ____     / ____/ (_)___ _/ /_  / /_   / ___/(_)___ ___  \n";
-        std::cout << "  / __  / _ \\/ ___/ __ \\/ __ `/ __ `__ \\/ __ \\   / /_  / / / __ `/ __ \\/ __/   \\__ \\/ / __ `__ \\ \n";
-        std::cout << " / /_/ /  __/ /__/ / / / /_/ / / / / / / /_/ /  / __/ / / / /_/ / / / / /_    ___/ / / / / / / / \n";
-        std::cout << "/_____/\\___/\\___/_/ /_/\\__,_/_/ /_/ /_/\\____/  /_/   /_/_/\\__, /_/ /_/\\__/   /____/_/_/ /_/ /_/  \n";
-        std::cout << "                                                         /____/                                  \n";
-        std::cout << "=================================================================================================\n";
-        std::cout << "=================================================================================================\n";
-        std::cout << "Version: " << version << " created on " << date << "\n";
-    // https://patorjk.com/software/taag/#p=display&f=Slant&t=Bechamo+Flight+Sim&x=none&v=4&h=4&w=80&we=false
+    /// @brief Shows VINFO statuses on screen too, not only in the system log
+    inline void setVerbose(bool verbose) {
+        std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+        verbose_ = verbose;
     }
 
-private:
-    void PrintStatusLine(const IStatusPrint& status);
-    size_t updateStatus(size_t index, const IStatusPrint status);
-    std::string pollingWaveform(int frame, int width);
+    /// @brief Logs every table row as a debug line of the system log
+    /// Off by default: a CSV line per sample costs the render thread and can
+    /// crowd statuses out of the logger's queue, --record keeps rows cheaper
+    inline void setLogTelemetry(bool log_telemetry) {
+        std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+        log_telemetry_ = log_telemetry;
+    }
 
-    inline void RestoreConsoleForShell(){
-        std::cout << "\033[0m";      // reset colors
-        std::cout << "\033[?25h";    // show cursor
-        std::cout << "\033[999;1H";  // move to bottom
-        std::cout << std::endl;      // ensure prompt starts cleanly
+    /// @brief Threads formatting table rows and status lines, this one
+    /// included; 1 formats everything on the render thread
+    /// Only frames with at least kParallelRows rows to format use them
+    inline void setFormatThreads(size_t threads) {
+        std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+        if (threads <= 1)
+            format_pool_.reset();
+        else if (!format_pool_ || format_pool_->threads() != threads)
+            format_pool_ = std::make_unique<FormatPool>(threads);
     }
 
-    inline void stopAllPolling() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        for (auto& [id, flag] : stop_flags_)
-            flag->store(true);
+    /// @brief Frames whose lines were formatted on the pool, not inline
+    inline size_t pooledFrames() const {
+        std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+        return pooled_frames_;
+    }
 
-        for (auto& [id, t] : threads_)
-            if (t.joinable())
-                t.join();
+    inline void setPaneLayout(PaneLayout layout) {
+        std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+        pane_layout_ = layout;
+    }
+
+    /// @brief Scrolls a table sideways: columns before first_column are
+    /// hidden and the pane shows as many of the next ones as fit
+    void scrollColumns(TableId table, size_t first_column);
 
-        threads_.clear();
-        stop_flags_.clear();
+    /// @brief Terminal size the frame is fitted to, 0 when unlimited
+    inline TerminalSize terminalSize() const {
+        std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+        return terminal_;
     }
-    void PrintRow(const std::string& line)
-    {
-        std::cout << "\033[K"; // clear line
-        std::cout << "[" << line << "]" << std::endl;
+
+    /// @brief Draws an instrument::Read summary under the tables, refreshed once a second
+    inline void setFooter(bool footer) {
+        std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+        footer_ = footer;
     }
 
-    inline void MoveCursorUp(int n){if (n > 0) std::cout << "\033[" << n << "A";}
-    inline void MoveCursorDown(int n){if (n > 0) std::cout << "\033[" << n << "B";}
-
-    std::string BuildFormat(const std::vector<Column>& columns) const{
-        std::string fmt_str;
-        for (size_t i = 0; i < columns.size(); ++i)
-        {
-            size_t index = i + 1; // {0} = width
-            if (columns[i].align == ColumnAlign::Center)
-                fmt_str += fmt::format("{{{}:^{{0}}}}", index);
-            else
-                fmt_str += fmt::format("{{{}:<{{0}}}}", index);
-        }
-        return fmt_str;
+    /// @brief Records every sample and status event from now on, nullptr stops
+    inline void attachRecorder(std::shared_ptr<FlightRecorder> recorder) {
+        std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+        recorder_ = std::move(recorder);
     }
 
-    fmt::dynamic_format_arg_store<fmt::format_context>
-    BuildArgs(const std::vector<Column>& columns) const
-    {
-        fmt::dynamic_format_arg_store<fmt::format_context> store;
-        store.push_back(column_width_);
-        for (const auto& c : columns)
-            store.push_back(c.title);
-        return store;
+    /// @brief Up to `max` of the newest statuses (with their ids), oldest first
+    /// Only the last kStatusHistoryRows are kept
+    inline std::vector<IStatusPrint> statusHistory(size_t max) const {
+        std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+        return status_rows_.History(max);
     }
 
-    /// @brief Move down cursor to "n" rows from top
-    inline void CursorMove(size_t n){
-        size_t total_rows = status_start_;
-        total_rows = total_rows + (size_t)status_rows_.size();
-        if (current_displayed_table_rows_ > 0){
-            total_rows = total_rows + current_displayed_table_rows_ + 3;
-        }
-        if (n < total_rows){
-            MoveCursorUp(total_rows - n);
-        }
+    /// @brief Bytes and write() calls spent on the last and all frames
+    inline FrameStats frameStats() const {
+        std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+        return compositor_.stats();
+    }
+
+    /// @brief Prints the banner above the console region, through the sink
+    inline void print_banner(std::string version, std::string date) {
+        std::string banner =
+            "=================================================================================================\n"
+            "=================================================================================================\n"
+            "    ____            __                             _________       __    __     _____ _          \n"
+            "   / __ )___  _____/ /_  ____ _____ ___  ____     / ____/ (_)___ _/ /_  / /_   / ___/(_)___ ___  \n"
+            "  / __  / _ \\/ ___/ __ \\/ __ `/ __ `__ \\/ __ \\   / /_  / / / __ `/ __ \\/ __/   \\__ \\/ / __ `__ \\ \n"
+            " / /_/ /  __/ /__/ / / / /_/ / / / / / / /_/ /  / __/ / / / /_/ / / / / /_    ___/ / / / / / / / \n"
+            "/_____/\\___/\\___/_/ /_/\\__,_/_/ /_/ /_/\\____/  /_/   /_/_/\\__, /_/ /_/\\__/   /____/_/_/ /_/ /_/  \n"
+            "                                                         /____/                                  \n"
+            "=================================================================================================\n"
+            "=================================================================================================\n";
+        banner += "Version: " + version + " created on " + date + "\n";
+        std::lock_guard<std::timed_mutex> lock(frame_mutex_);
+        compositor_.WriteRaw(banner);
+    // https://patorjk.com/software/taag/#p=display&f=Slant&t=Bechamo+Flight+Sim&x=none&v=4&h=4&w=80&we=false
     }
 
+private:
+    /// @brief Slot of the telemetry ring, text is only used by ITelemetryPrint rows
+    struct TelemetryRow {
+        TelemetrySample sample;
+        std::vector<std::string> text;
+    };
+
+    /// @brief One telemetry pane: its own rows, refresh cap and drawn lines
+    struct Table {
+        explicit Table(const TableOptions& options)
+            : name(options.name),
+              rows(std::max<size_t>(options.max_rows, 1)),
+              interval(options.refresh_hz > 0
+                  ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(1.0 / options.refresh_hz))
+                  : std::chrono::steady_clock::duration::zero()),
+              window_samples(options.window_samples),
+              window_time(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                  std::chrono::duration<double>(std::max(options.window_s, 0.0)))) {}
+
+        inline bool windowed() const {
+            return window_samples > 0 || window_time > std::chrono::steady_clock::duration::zero();
+        }
+
+        std::string name;
+        boost::circular_buffer<TelemetryRow> rows;
+        std::chrono::steady_clock::duration interval;
+        /* summary rows: window length in samples and/or time */
+        size_t window_samples;
+        std::chrono::steady_clock::duration window_time;
+        std::chrono::steady_clock::time_point window_start{};
+        /* statistics of the window shown by rows.back() */
+        WindowAggregator window{};
+        std::chrono::steady_clock::time_point built{};
+        /* rows changed since lines were built */
+        bool dirty{false};
+        /* formatted pane, reused by every frame until the rows change */
+        std::vector<std::string> lines{};
+        size_t line_count{0};
+        size_t width{0};
+        /* horizontal scroll, first schema column drawn */
+        size_t first_column{0};
+        /* characters the pane may use, 0 when unlimited */
+        size_t budget{0};
+        /* layout of the lines being built, set with their header */
+        SchemaHandle schema{};
+        int precision{2};
+        size_t header_lines{0};
+        /* schema columns [first, last) are drawn, from line offset begin */
+        size_t first{0};
+        size_t last{0};
+        size_t begin{1};
+        size_t end{1};
+    };
+
+    /// @brief Lines formatted by one job of the format pool: rows
+    /// [first, first + count) of a table, or status lines when table is null
+    struct FormatJob {
+        Table* table;
+        size_t first;
+        size_t count;
+    };
+
+    static const char* LevelName(ConsoleLevels level);
+    void FormatStatusLine(const IStatusPrint& status, std::string& out) const;
+    /// @brief Puts the parked spinners from first_drawn on back on the wheel
+    void UnparkSpinners(size_t first_drawn);
+    /// @brief Enqueues a CSV line on the (async) system logger
+    void LogStatus(const IStatusPrint& status) const;
+    void LogSample(const TelemetrySample& sample, const std::vector<std::string>* text) const;
+    size_t AppendStatus(const IStatusPrint& status, flight_log::StatusEvent event);
+    /// @brief Precomputed strings and cell offsets of one schema
+    struct TableLayout {
+        bool valid{false};
+        size_t width{};                /* printable width, brackets excluded */
+        std::string separator;         /* "[====...]" */
+        std::string header;            /* "[ Time(s)  Agl(m) ...]" */
+        std::string blank_row;         /* "[      ...      ]" row template */
+        std::vector<size_t> offsets;   /* first char of each cell in a line */
+        std::vector<size_t> widths;
+        std::vector<ColumnAlign> aligns;
+        /* Static layouts: rows of this schema are written whole by format
+           when every column is on screen, cell by cell otherwise */
+        SchemaHandle schema{};
+        void (*format)(const TelemetrySample& sample, char* line){nullptr};
+        size_t (*format_cell)(const TelemetrySample& sample, size_t column, char* cell){nullptr};
+    };
+
+    /// @brief Returns the cached layout of a schema, building it on first use
+    const TableLayout& Layout(SchemaHandle handle);
+    /// @brief Some table changed and its refresh cap lets it be rebuilt
+    bool TablesDue(std::chrono::steady_clock::time_point now) const;
+    /// @brief Lays out a changed table once its refresh cap allows it: the
+    /// header lines are built, its rows are queued as format jobs
+    void BuildTable(Table& table, std::chrono::steady_clock::time_point now);
+    void FormatHeader(const TableLayout& layout, Table& table);
+    /// @brief A full-width table line cut to the drawn columns, with its
+    /// brackets turned into '<' / '>' on a side with hidden columns
+    static void FrameLine(const TableLayout& layout, const Table& table,
+                          const std::string& full, std::string& line);
+    /// @brief Formats rows [first, first + count) into their table lines
+    /// Reads the frame model only, safe to run on several threads at once
+    void FormatRows(Table& table, size_t first, size_t count) const;
+    /// @brief Runs the queued format jobs, on the pool when worth it
+    void RunFormatJobs();
+    void RunFormatJob(const FormatJob& job);
+    std::string& TableLine(Table& table);
+    /// @brief Table a row is posted to, unknown ids fall back to the default
+    Table& TableFor(TableId id);
+    /// @brief Writes text into the cell at offset, aligned and cut to width
+    static void PlaceCell(std::string& line, size_t offset, size_t width, ColumnAlign align,
+                          const char* text, size_t len);
+    /// @brief Formats value n of a sample into buf, returns the length
+    size_t FormatCell(const TelemetrySample& sample, size_t n, int precision, char* buf, size_t size) const;
+    /// @brief Adds a posted row to its table, logging and recording it
+    void AppendRow(Table& table, const TelemetrySample& sample, const std::vector<std::string>* text);
+    /// @brief Folds a sample into the live summary row of a windowed table
+    void AggregateRow(Table& table, const TelemetrySample& sample, bool new_layout);
+    /// @brief Claims the next ring slot, reusing the oldest one once full
+    TelemetryRow& NextRow(Table& table);
+    /// @brief Gives each table the width it may use, a table whose width
+    /// changed is rebuilt in the next frame
+    void FitPanes();
+    /// @brief Cuts a line to `columns` terminal cells, 0 keeps it whole
+    static void ClipToWidth(std::string& line, size_t columns);
+    /// @brief Builds the status + table frame and flushes the changed lines
+    /// frame_mutex_ must be held by the caller
+    void Render(bool full_redraw);
+    size_t updateStatus(size_t index, const IStatusPrint& status);
+    static void AppendWaveform(int frame, int width, StatusText& out);
+
+    static constexpr std::string_view kRestoreConsole = "\033[0m"      // reset colors
+                                                        "\033[?25h"    // show cursor
+                                                        "\033[999;1H"  // move to bottom
+                                                        "\n";          // ensure prompt starts cleanly
+
+    /// @brief frame_mutex_ must be held by the caller, only the first call writes
+    inline void RestoreConsoleForShell(){
+        if (restored_)
+            return;
+        restored_ = true;
+        std::cout.flush(); // whatever the application printed itself goes first
+        compositor_.WriteRaw(kRestoreConsole);
+    }
 private:
     std::shared_ptr<spdlog::logger> logger_;
     int column_width_;
 
-    /* Rows from the top to place table */
-    size_t table_start_;
-    /* Maximum num of telemetry rows to display */
-    size_t max_table_rows_;
-    /* Current num of telemetry row displayed */
-    size_t current_displayed_table_rows_;
-    /* Telemetry row data */
-    boost::circular_buffer<ITelemetryPrint>table_rows_;
-    
-    /* Rows from the top to place first status row */
-    size_t status_start_;
-    /* Status row data */
-    std::vector<IStatusPrint> status_rows_{};
-
-    std::unordered_map<size_t, std::thread> threads_;
-    std::unordered_map<size_t, std::shared_ptr<std::atomic<bool>>> stop_flags_;
-    std::mutex mutex_;
+    /* Telemetry tables by TableId, kDefaultTable first */
+    std::deque<Table> tables_{};
+    PaneLayout pane_layout_{PaneLayout::Stacked};
+    static constexpr size_t kPaneGap = 2;
+    /* Column layouts referenced by table rows */
+    SchemaRegistry schemas_{};
+    /* Layout cache indexed by schema handle */
+    std::vector<TableLayout> layouts_{};
+
+    /* Statuses kept for history queries and updates by id */
+    static constexpr size_t kStatusHistoryRows = 1024;
+    /* Status row data, the newest max_status_rows are drawn */
+    StatusRegion status_rows_;
+
+    /* Diffs each frame against the last one sent to the terminal */
+    FrameCompositor compositor_;
+    /* Frame lines are cut to the width, the frame is kept below the height */
+    TerminalSize terminal_;
+    /* Formatting work of the frame being built */
+    static constexpr size_t kRowsPerJob = 8;
+    static constexpr size_t kParallelRows = 64;
+    std::unique_ptr<FormatPool> format_pool_{};
+    std::vector<FormatJob> format_jobs_{};
+    size_t format_rows_{0};
+    size_t pooled_frames_{0};
+    /* Status lines of the frame, formatted by jobs and swapped into it */
+    std::vector<const IStatusPrint*> visible_statuses_{};
+    std::vector<std::string> status_lines_{};
+
+    /* VINFO statuses are drawn, not only logged */
+    bool verbose_{false};
+    /* Table rows are logged too, not only statuses and schemas */
+    bool log_telemetry_{false};
+
+    /* Instrumentation footer, rates are taken between footer refreshes */
+    static constexpr std::chrono::seconds kFooterPeriod{1};
+    bool footer_{false};
+    std::string footer_text_{};
+    instrument::Snapshot footer_prev_{};
+    std::chrono::steady_clock::time_point footer_at_{};
+
+    /* Optional binary log of everything shown */
+    std::shared_ptr<FlightRecorder> recorder_{};
+    /* shutdown() already handed the terminal back */
+    bool restored_{false};
+
+    /* Guards the frame model, frameStats() is read from other threads */
+    /* Timed so a shutdown from a signal can give up on a stuck render */
+    mutable std::timed_mutex frame_mutex_;
+
+    /// @brief Polled status animated by the shared wheel
+    struct Spinner {
+        IStatusPrint status;
+        uint8_t frame;
+        /* Scrolled out of the drawn statuses, off the wheel until drawn again */
+        bool parked{false};
+    };
+    /* Active polling animations by status id, erased on stop */
+    std::unordered_map<size_t, Spinner> spinners_;
+    /* Oldest status id the last frame drew, older spinners are parked */
+    size_t first_drawn_status_{0};
+    static constexpr int kPollIntervalMs = 200;
+    /* One wheel tick per animation frame for every spinner */
+    TimerWheel animation_wheel_{std::chrono::milliseconds(kPollIntervalMs)};
 };
\ No newline at end of file
@@ -1,16 +1,37 @@
 #ifndef CLARKESIM_SRC_COMMON_THREAD_MANAGER_H_
 #define CLARKESIM_SRC_COMMON_THREAD_MANAGER_H_
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "header_registry.h"
+#include "inline_string.h"
 
 enum class ColumnAlign {
     Left,
     Center
 };
 
+/// @brief What a column of a windowed table shows for each window
+/// Tables without a window always show the raw value (Last)
+enum class Aggregate : uint8_t {
+    Last,   /* newest value */
+    Min,
+    Max,
+    Mean,
+    StdDev, /* population standard deviation */
+    Rate    /* change per second from the first to the newest value, timed by
+               when the console applied each sample (samples carry no time) */
+};
+
 struct Column {
     std::string title;
     ColumnAlign align;
+    Aggregate aggregate{Aggregate::Last};
 };
 
 enum ConsoleLevels {
@@ -20,40 +41,163 @@ enum ConsoleLevels {
     ERROR  /* used for error handling */
 };
 
+/// @brief Longest status message kept, longer text is cut
+constexpr size_t kStatusTextCapacity = 207;
+using StatusText = InlineString<kStatusTextCapacity>;
+
 /// @brief Used to display status messages to the console
 /// Format: [<level>][<header>] <data> - where the level is also color coded
+/// Holds no heap memory, posting one is a copy into the executor task
 struct IStatusPrint {
     ConsoleLevels level;
-    std::string header;
-    std::string data;
+    StatusHeader header;
+    StatusText data;
     size_t id{}; // not always needed
 };
+static_assert(sizeof(IStatusPrint) <= 256, "IStatusPrint must fit the inline storage of a posted task");
+
+/// @brief Handle of a telemetry table created with IConsole::addTable
+using TableId = uint32_t;
+
+/// @brief Table every console starts with, used when no table is given
+constexpr TableId kDefaultTable = 0;
+
+/// @brief Settings of a named telemetry table
+struct TableOptions {
+    std::string name;        /* drawn above the table */
+    size_t max_rows{12};     /* newest rows kept and drawn */
+    double refresh_hz{0.0};  /* cap on rebuilding the table, 0 follows the console */
+    /* Either set: each row summarizes a window of samples (see Aggregate)
+       instead of showing one sample, the newest row updates live;
+       window_s is measured on the console thread as samples are applied */
+    size_t window_samples{0};
+    double window_s{0.0};
+};
 
 /// @brief Used transfer telemetry data to the console
 struct ITelemetryPrint {
     std::vector<Column> columns;
     std::vector<std::string> data;
+    TableId table{kDefaultTable};
+};
+
+/// @brief Max number of values a TelemetrySample can carry
+constexpr size_t kMaxTelemetryColumns = 32;
+
+/// @brief Handle of a column layout registered with IConsole::registerSchema
+using SchemaHandle = uint32_t;
+
+struct TelemetrySample;
+
+/// @brief Table lines fixed at compile time, see TelemetryTable
+/// The views point at static storage and are all the same length
+struct StaticLayout {
+    std::string_view header{};
+    std::string_view separator{};
+    std::string_view blank_row{};
+    /* Writes a whole row, separator.size() chars, for a sample of the schema */
+    void (*format)(const TelemetrySample& sample, char* line){nullptr};
+    /* Width of each column, one per schema column */
+    const size_t* widths{nullptr};
+    /* Text of one cell (at most fast_format::kMaxCellChars), for rows
+       only partly on screen; returns its length */
+    size_t (*format_cell)(const TelemetrySample& sample, size_t column, char* cell){nullptr};
+};
+
+/// @brief Column layout shared by every sample posted with its handle
+struct TelemetrySchema {
+    std::vector<Column> columns;
+    int precision{2}; // digits after the decimal point for double values
+    StaticLayout layout{}; // set by registerStaticSchema, empty otherwise
+};
+
+/// @brief Raw telemetry value, only formatted when its row is drawn
+union TelemValue {
+    double f;
+    int64_t i;
+};
+
+/// @brief Fixed-size, allocation free telemetry row
+/// Values are matched to the columns of the schema by position
+struct TelemetrySample {
+    SchemaHandle schema{};
+    uint32_t count{};
+    uint32_t int_mask{}; // bit n set: values[n] holds an int64
+    TableId table{kDefaultTable};
+    std::array<TelemValue, kMaxTelemetryColumns> values{};
+
+    /// @brief Appends a value, extra values past kMaxTelemetryColumns are dropped
+    template<typename T>
+    inline TelemetrySample& push(T val){
+        static_assert(std::is_arithmetic_v<T>, "telemetry values must be numeric");
+        if (count >= kMaxTelemetryColumns)
+            return *this;
+        if constexpr (std::is_integral_v<T>){
+            values[count].i = static_cast<int64_t>(val);
+            int_mask |= (1u << count);
+        } else {
+            values[count].f = static_cast<double>(val);
+        }
+        ++count;
+        return *this;
+    }
+
+    inline bool is_int(size_t n) const { return (int_mask >> n) & 1u; }
 };
 
+/// @brief Status id returned for messages that are logged but not shown
+/// (VINFO outside of verbose mode), updates to it are ignored
+constexpr size_t kHiddenStatusId = SIZE_MAX;
+
 /// @brief Interface to ConsoleTablePrinter class 
 /// calls to these functions will be placed into async queue
 struct IConsole {
-    /// @brief Appends a new status message above the Telemetry table
+    /// @brief Appends a new status message above the Telemetry table,
+    /// shown by the next printTelemTable call
     /// @return unique ID of status message created
-    virtual size_t newStatus(const IStatusPrint status)=0;
+    virtual size_t newStatus(const IStatusPrint& status)=0;
 
     virtual bool addTelemetry(const ITelemetryPrint telem)=0;
 
+    /// @brief Declares a column layout once for TelemetrySample producers
+    /// @return handle to stamp into TelemetrySample::schema
+    virtual SchemaHandle registerSchema(std::vector<Column> columns, int precision)=0;
+
+    /// @brief registerSchema for a TelemetryTable, whose rows can be drawn
+    /// with its compile-time layout; consoles that do not draw (or cannot
+    /// keep the function pointer) register the runtime columns only
+    virtual SchemaHandle registerStaticSchema(std::vector<Column> columns, int precision, const StaticLayout& layout){
+        (void)layout;
+        return registerSchema(std::move(columns), precision);
+    }
+
+    /// @brief Creates a table with its own rows, drawn as a separate pane
+    /// @return id to stamp into TelemetrySample::table / ITelemetryPrint::table
+    virtual TableId addTable(const TableOptions& options)=0;
+
+    /// @brief Appends a typed telemetry row, formatted lazily when drawn
+    virtual bool addSample(const TelemetrySample& sample)=0;
+
     ///@brief Creates a polling animation status message 
-    virtual size_t startPolling(const IStatusPrint status)=0;
+    virtual size_t startPolling(const IStatusPrint& status)=0;
 
     ///@brief Stops existing polling animation
     ///@param status New message to display after polling finishes
-    virtual void stopPolling(size_t id, const IStatusPrint status)=0;
+    virtual void stopPolling(size_t id, const IStatusPrint& status)=0;
+
+    ///@brief Steps time driven state: polling animations that are due at
+    /// now and tables whose refresh cap held back an update
+    ///@return true when something changed and the console needs a redraw
+    virtual bool advanceAnimations(std::chrono::steady_clock::time_point now)=0;
 
-    /// @brief Handles new line in the Telemetry table
+    /// @brief Redraws the statuses and the Telemetry tables
+    /// @param full_redraw repaint every line instead of only changed ones
     virtual void printTelemTable(bool full_redraw)=0;
 
+    /// @brief The terminal was resized, the console re-reads its size
+    /// @return true when the next redraw must repaint every line
+    virtual bool terminalResized(){ return false; }
+
     /// @brief Can be used to generate ITelemetryPrint objects
     virtual std::vector<std::string> convert_data(const std::vector<double>& data)=0;
 };
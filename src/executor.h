@@ -0,0 +1,757 @@
+#ifndef CLARKESIM_SRC_COMMON_EXECUTOR_H_
+#define CLARKESIM_SRC_COMMON_EXECUTOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "instrumentation.h"
+
+/// @brief Move-only void() callable with inline storage for small captures
+///
+/// Callables up to kInlineSize bytes (every ThreadManager post, including a
+/// TelemetrySample capture) are stored in place, larger ones fall back to
+/// the heap. Unlike std::function posting one never allocates on its own.
+class SmallTask {
+public:
+    static constexpr size_t kInlineSize = 320;
+
+    SmallTask() noexcept = default;
+
+    template<typename F,
+             typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, SmallTask>>>
+    SmallTask(F&& f) {
+        using Fn = std::decay_t<F>;
+        if constexpr (FitsInline<Fn>()) {
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+            ops_ = &kInlineOps<Fn>;
+        } else {
+            *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(f));
+            ops_ = &kHeapOps<Fn>;
+        }
+    }
+
+    SmallTask(SmallTask&& other) noexcept { MoveFrom(other); }
+
+    SmallTask& operator=(SmallTask&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    SmallTask(const SmallTask&) = delete;
+    SmallTask& operator=(const SmallTask&) = delete;
+
+    ~SmallTask() { Reset(); }
+
+    inline explicit operator bool() const { return ops_ != nullptr; }
+    inline void operator()() { ops_->invoke(storage_); }
+
+    inline void Reset() {
+        if (ops_) ops_->destroy(storage_);
+        ops_ = nullptr;
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void*);
+    };
+
+    template<typename Fn>
+    static constexpr bool FitsInline() {
+        return sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template<typename Fn>
+    static constexpr Ops kInlineOps{
+        [](void* p) { (*static_cast<Fn*>(p))(); },
+        [](void* dst, void* src) {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* p) { static_cast<Fn*>(p)->~Fn(); }};
+
+    template<typename Fn>
+    static constexpr Ops kHeapOps{
+        [](void* p) { (**static_cast<Fn**>(p))(); },
+        [](void* dst, void* src) { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); },
+        [](void* p) { delete *static_cast<Fn**>(p); }};
+
+    inline void MoveFrom(SmallTask& other) noexcept {
+        if (other.ops_) {
+            other.ops_->move(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const Ops* ops_{nullptr};
+};
+
+/// @brief Message class of a posted task, picks what a full queue does with it
+enum class TaskClass : uint8_t {
+    Telemetry, /* table rows, dropped per TelemetryOverflow when the queue is full */
+    Status,    /* status lines, never dropped, the poster waits for room instead */
+    Control    /* polling start/stop and ticks, never dropped, run before queued work */
+};
+
+/// @brief What a full queue does with one more telemetry task
+enum class TelemetryOverflow : uint8_t {
+    DropOldest,    /* the oldest queued row is dropped */
+    ReplaceLatest, /* the newest queued row is replaced */
+    DropNewest,    /* the incoming row is dropped, the queue is left as is */
+    Wait           /* the poster waits, nothing is lost (replay, benchmarks) */
+};
+
+/// @brief Executor queue counters, see SimExecutor::Stats
+struct QueueStats {
+    size_t depth{0};           /* tasks queued right now */
+    size_t max_depth{0};
+    uint64_t posted{0};
+    uint64_t dropped{0};       /* telemetry dropped or replaced by a newer row */
+    uint64_t waited{0};        /* posts that had to wait for room */
+    uint64_t high_water{0};    /* times the depth crossed QueueLimits::high_water */
+    std::chrono::nanoseconds max_latency{0}; /* longest wait from post to run */
+};
+
+/// @brief Bounds of an executor queue
+struct QueueLimits {
+    size_t capacity{1024};       /* queued telemetry tasks */
+    size_t status_capacity{256}; /* queued status and control tasks before posters wait */
+    TelemetryOverflow telemetry{TelemetryOverflow::DropOldest};
+    size_t high_water{512};      /* depth that fires on_high_water, 0 disables it */
+    /* called on the posting thread once per crossing, re-armed when the
+       depth falls back to half the mark. Keep it short, it may not post
+       status or control tasks itself */
+    std::function<void(const QueueStats&)> on_high_water{};
+};
+
+/// @brief Outcome of SimExecutor::Shutdown
+struct ShutdownStats {
+    size_t queued{0};    /* tasks queued when the executor closed */
+    size_t dropped{0};   /* of those, still queued at the deadline and dropped */
+    bool drained{false}; /* everything queued ran and the executor thread exited */
+};
+
+/// @brief  Decouples sim executor type from api
+/// concretely SingleThreadExecutor, potential multithreaded executor or synchronous in the future
+class SimExecutor {
+public:
+    using Task = SmallTask;
+    using Clock = std::chrono::steady_clock;
+    explicit SimExecutor(QueueLimits limits = {}) : limits_(std::move(limits)) {}
+    virtual ~SimExecutor() = default;
+    virtual void Post(Task task, TaskClass cls = TaskClass::Status) = 0;
+
+    /// @brief Runs tick on the executor thread every period, between tasks
+    /// An empty tick task removes it
+    inline void SetTick(std::chrono::nanoseconds period, Task tick) {
+        // installed on the executor thread, so Run never races with it
+        Post([this, period, tick = std::move(tick)]() mutable {
+            tick_period_ = period;
+            tick_ = std::move(tick);
+            next_tick_ = Clock::now() + period;
+        }, TaskClass::Control);
+    }
+
+    /// @brief Stops taking tasks and runs what is queued until deadline
+    ///
+    /// Posts from now on are dropped (QueueStats::dropped). Once the queue
+    /// is empty the tick runs one last time and the thread exits; tasks
+    /// still queued at the deadline are dropped unrun. A task already
+    /// running is not interrupted: Shutdown returns at the deadline anyway
+    /// and the destructor joins the thread. Call from any thread but the
+    /// executor's own, later calls only wait for the thread again.
+    inline ShutdownStats Shutdown(Clock::time_point deadline) {
+        ShutdownStats stats;
+        stats.queued = depth_.load(std::memory_order_relaxed);
+        closed_.store(true, std::memory_order_release);
+        WakeAll();
+        stats.drained = WaitExited(deadline);
+        if (!stats.drained) {
+            stats.dropped = depth_.load(std::memory_order_relaxed);
+            discard_.store(true, std::memory_order_release);
+            WakeAll();
+        }
+        return stats;
+    }
+
+    /// @brief Snapshot of the queue counters, callable from any thread
+    inline QueueStats Stats() const {
+        QueueStats stats;
+        stats.depth = depth_.load(std::memory_order_relaxed);
+        stats.max_depth = max_depth_.load(std::memory_order_relaxed);
+        stats.posted = posted_.load(std::memory_order_relaxed);
+        stats.dropped = dropped_.load(std::memory_order_relaxed);
+        stats.waited = waited_.load(std::memory_order_relaxed);
+        stats.high_water = high_water_.load(std::memory_order_relaxed);
+        stats.max_latency = std::chrono::nanoseconds(max_latency_ns_.load(std::memory_order_relaxed));
+        return stats;
+    }
+
+protected:
+    inline const QueueLimits& limits() const { return limits_; }
+
+    /// @brief Wakes the executor thread and waiting posters, to see Shutdown
+    virtual void WakeAll() = 0;
+
+    /// @brief Shutdown was called, the queue takes no more tasks
+    inline bool Closed() const { return closed_.load(std::memory_order_acquire); }
+    /// @brief Shutdown's deadline passed, queued tasks are dropped unrun
+    inline bool Discarding() const { return discard_.load(std::memory_order_acquire); }
+
+    /// @brief Counts a post made after Shutdown as dropped
+    /// @return true when the caller must drop the task
+    inline bool DropClosed() {
+        if (!Closed())
+            return false;
+        posted_.fetch_add(1, std::memory_order_relaxed);
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// @brief Called by the executor thread as it leaves its loop; a
+    /// drained shutdown gets the tick once more, e.g. for a last frame
+    inline void Exiting() {
+        if (Closed() && !Discarding() && tick_)
+            tick_();
+        std::lock_guard<std::mutex> lock(exit_mutex_);
+        exited_ = true;
+        exit_cv_.notify_all();
+    }
+
+    /// @brief Counts a task entering the queue, before a consumer can see it
+    /// @return the new depth, for CheckHighWater
+    inline size_t CountPosted() {
+        posted_.fetch_add(1, std::memory_order_relaxed);
+        size_t depth = depth_.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t max = max_depth_.load(std::memory_order_relaxed);
+        while (depth > max && !max_depth_.compare_exchange_weak(max, depth, std::memory_order_relaxed)) {}
+        instrument::Count(instrument::kPosts);
+        instrument::SetQueueDepth(depth);
+        return depth;
+    }
+
+    /// @brief Counts a queued telemetry task dropped before it ran
+    inline void CountDropped() {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        depth_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    inline void CountWaited() { waited_.fetch_add(1, std::memory_order_relaxed); }
+
+    /// @brief Counts a task leaving the queue to run, executor thread only
+    inline void CountRun(Clock::time_point posted) {
+        size_t depth = depth_.fetch_sub(1, std::memory_order_relaxed) - 1;
+        int64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - posted).count();
+        if (latency > max_latency_ns_.load(std::memory_order_relaxed))
+            max_latency_ns_.store(latency, std::memory_order_relaxed);
+        instrument::Count(instrument::kTasksRun);
+        instrument::Record(instrument::kPostToRunNs, static_cast<uint64_t>(latency));
+        instrument::SetQueueDepth(depth);
+        if (depth <= limits_.high_water / 2)
+            high_water_armed_.store(true, std::memory_order_relaxed);
+    }
+
+    /// @brief Fires on_high_water for a depth from CountPosted, call with
+    /// no queue lock held
+    inline void CheckHighWater(size_t depth) {
+        if (limits_.high_water == 0 || depth < limits_.high_water ||
+            !high_water_armed_.exchange(false, std::memory_order_relaxed))
+            return;
+        high_water_.fetch_add(1, std::memory_order_relaxed);
+        if (limits_.on_high_water)
+            limits_.on_high_water(Stats());
+    }
+
+    /// @brief Runs the tick when due, call from the executor thread only
+    inline void RunTickIfDue(Clock::time_point now) {
+        if (!tick_ || now < next_tick_)
+            return;
+        tick_();
+        // skip missed ticks rather than bursting to catch up
+        next_tick_ += tick_period_;
+        if (next_tick_ <= now)
+            next_tick_ = now + tick_period_;
+    }
+
+    /// @brief Deadline of the next tick, an hour out when none is set
+    inline Clock::time_point NextTick() const {
+        return tick_ ? next_tick_ : Clock::now() + std::chrono::hours(1);
+    }
+
+private:
+    inline bool WaitExited(Clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(exit_mutex_);
+        return exit_cv_.wait_until(lock, deadline, [this] { return exited_; });
+    }
+
+    Task tick_{};
+    std::chrono::nanoseconds tick_period_{};
+    Clock::time_point next_tick_{};
+
+    /* Shutdown state, see Shutdown */
+    std::atomic<bool> closed_{false};
+    std::atomic<bool> discard_{false};
+    std::mutex exit_mutex_;
+    std::condition_variable exit_cv_;
+    bool exited_{false};
+
+    const QueueLimits limits_;
+    std::atomic<size_t> depth_{0};
+    std::atomic<size_t> max_depth_{0};
+    std::atomic<uint64_t> posted_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> waited_{0};
+    std::atomic<uint64_t> high_water_{0};
+    std::atomic<int64_t> max_latency_ns_{0};
+    std::atomic<bool> high_water_armed_{true};
+};
+
+/// @brief Executor on a mutex + condition variable queue, bounded per TaskClass
+///
+/// Telemetry, status and control tasks wait in separate queues so a full
+/// telemetry queue can shed rows without touching statuses. Control runs
+/// first, status and telemetry run in the order they were posted.
+class SingleThreadExecutor : public SimExecutor {
+public:
+    explicit SingleThreadExecutor(QueueLimits limits = {})
+        : SimExecutor(std::move(limits)),
+          running_(true),
+          thread_(&SingleThreadExecutor::Run, this) {}
+
+    ~SingleThreadExecutor() override {
+        Stop();
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    void Post(Task task, TaskClass cls = TaskClass::Status) override {
+        if (DropClosed())
+            return;
+        Entry entry{std::move(task), 0, Clock::now()};
+        size_t depth;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (cls == TaskClass::Telemetry) {
+                if (telemetry_.size() >= limits().capacity) {
+                    switch (limits().telemetry) {
+                        case TelemetryOverflow::DropOldest:
+                            telemetry_.pop_front();
+                            CountDropped();
+                            break;
+                        case TelemetryOverflow::ReplaceLatest:
+                            telemetry_.pop_back();
+                            CountDropped();
+                            break;
+                        case TelemetryOverflow::DropNewest:
+                            CountPosted();
+                            CountDropped();
+                            return;
+                        case TelemetryOverflow::Wait:
+                            WaitForRoom(lock, [&] { return telemetry_.size() < limits().capacity; });
+                            if (DropClosed())
+                                return;
+                            break;
+                    }
+                }
+                entry.seq = next_seq_++;
+                depth = CountPosted();
+                telemetry_.push_back(std::move(entry));
+            } else {
+                WaitForRoom(lock, [&] {
+                    return status_.size() + control_.size() < limits().status_capacity;
+                });
+                if (DropClosed())
+                    return;
+                entry.seq = next_seq_++;
+                depth = CountPosted();
+                (cls == TaskClass::Control ? control_ : status_).push_back(std::move(entry));
+            }
+        }
+        cv_.notify_one();
+        CheckHighWater(depth);
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        cv_.notify_all();
+        room_cv_.notify_all();
+    }
+
+private:
+    struct Entry {
+        Task task;
+        uint64_t seq;
+        Clock::time_point posted;
+    };
+
+    void WakeAll() override {
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        cv_.notify_all();
+        room_cv_.notify_all();
+    }
+
+    /// @brief Blocks the poster until room() holds. Never waits on the
+    /// executor thread itself (a task posting more work) or while stopping
+    template<typename Room>
+    void WaitForRoom(std::unique_lock<std::mutex>& lock, Room room) {
+        if (room() || std::this_thread::get_id() == thread_.get_id())
+            return;
+        CountWaited();
+        ++waiters_;
+        room_cv_.wait(lock, [&] { return room() || !running_ || Closed(); });
+        --waiters_;
+    }
+
+    /// @brief Moves the next task to run into entry, false when all queues are empty
+    bool PopNext(Entry& entry) {
+        std::deque<Entry>* from = nullptr;
+        if (!control_.empty())
+            from = &control_;
+        else if (!status_.empty() && (telemetry_.empty() || status_.front().seq < telemetry_.front().seq))
+            from = &status_;
+        else if (!telemetry_.empty())
+            from = &telemetry_;
+        else
+            return false;
+        entry = std::move(from->front());
+        from->pop_front();
+        return true;
+    }
+
+    inline bool Empty() const { return control_.empty() && status_.empty() && telemetry_.empty(); }
+
+    void Run() {
+        while (true) {
+            Entry entry;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait_until(lock, NextTick(), [&] {
+                    return !Empty() || !running_ || Closed();
+                });
+
+                // Stop and Shutdown both finish what is queued first
+                if ((!running_ || Closed()) && Empty())
+                    break;
+
+                if (PopNext(entry) && waiters_ > 0)
+                    room_cv_.notify_all();
+            }
+
+            if (entry.task) {
+                if (Discarding()) {
+                    CountDropped();
+                    continue;
+                }
+                CountRun(entry.posted);
+                entry.task();
+            }
+            RunTickIfDue(Clock::now());
+        }
+        Exiting();
+    }
+
+    std::deque<Entry> control_;
+    std::deque<Entry> status_;
+    std::deque<Entry> telemetry_;
+    uint64_t next_seq_{0};
+    size_t waiters_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable room_cv_;
+    bool running_;
+    std::thread thread_;
+};
+
+/// @brief Single consumer executor fed by a bounded lock-free ring
+///
+/// Producers claim slots with a CAS on the enqueue index (Vyukov bounded
+/// queue), so posting never takes a lock. The consumer spins briefly when
+/// the ring runs dry and then parks on a condition variable; producers only
+/// touch the mutex when the consumer is actually parked. A full ring makes
+/// producers back off until the consumer frees a slot, or until Shutdown;
+/// a task posting into a full ring from the consumer thread cannot wait
+/// for itself and its post is dropped instead.
+///
+/// Telemetry may fill the ring only up to QueueLimits::capacity, leaving
+/// status_capacity slots for statuses. The ring cannot take a queued row
+/// back out, so only DropNewest (the incoming row is dropped) and Wait are
+/// accepted; DropOldest and ReplaceLatest throw std::invalid_argument.
+/// Control tasks skip the ring through a small locked queue the consumer
+/// checks first.
+class MpscExecutor : public SimExecutor {
+public:
+    /// @param capacity ring slots, rounded up to a power of two
+    explicit MpscExecutor(size_t capacity = 1024, QueueLimits limits = {})
+        : SimExecutor(std::move(limits)),
+          mask_(RoundUpPow2(capacity) - 1),
+          slots_(mask_ + 1),
+          telemetry_limit_(std::min(this->limits().capacity,
+                                    mask_ + 1 - std::min(this->limits().status_capacity, mask_))),
+          running_(true) {
+        TelemetryOverflow overflow = this->limits().telemetry;
+        if (overflow == TelemetryOverflow::DropOldest || overflow == TelemetryOverflow::ReplaceLatest)
+            throw std::invalid_argument("MpscExecutor drops only the incoming row: use DropNewest or Wait");
+        for (size_t i = 0; i <= mask_; ++i)
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        thread_ = std::thread(&MpscExecutor::Run, this);
+    }
+
+    ~MpscExecutor() override {
+        Stop();
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    void Post(Task task, TaskClass cls = TaskClass::Status) override {
+        // Run does not exit while a post is in flight, and a post that
+        // starts after Run saw the executor closed is dropped here
+        InFlight in_flight(posting_);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (DropClosed())
+            return;
+        bool on_executor = std::this_thread::get_id() == thread_.get_id();
+        auto posted = Clock::now();
+        if (cls == TaskClass::Control) {
+            size_t depth;
+            {
+                std::lock_guard<std::mutex> lock(control_mutex_);
+                depth = CountPosted();
+                control_.push_back({std::move(task), posted});
+            }
+            control_pending_.fetch_add(1, std::memory_order_release);
+            Wake();
+            CheckHighWater(depth);
+            return;
+        }
+        if (cls == TaskClass::Telemetry && Queued() >= telemetry_limit_) {
+            if (limits().telemetry != TelemetryOverflow::Wait || on_executor) {
+                // counted like a queued row that was dropped
+                CountPosted();
+                CountDropped();
+                return;
+            }
+            CountWaited();
+            for (size_t spins = 0; Queued() >= telemetry_limit_ && running_.load() && !Closed(); )
+                Backoff(spins++);
+            if (DropClosed())
+                return;
+        }
+
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        bool waited = false;
+        for (size_t spins = 0;; ) {
+            slot = &slots_[pos & mask_];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                // ring is full, wait for the consumer to free the slot; the
+                // consumer itself would wait forever
+                if (on_executor) {
+                    CountPosted();
+                    CountDropped();
+                    return;
+                }
+                if (DropClosed())
+                    return;
+                if (!waited) CountWaited();
+                waited = true;
+                Backoff(spins++);
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->task = std::move(task);
+        slot->posted = posted;
+        size_t depth = CountPosted();
+        slot->seq.store(pos + 1, std::memory_order_release);
+        Wake();
+        CheckHighWater(depth);
+    }
+
+    void Stop() {
+        running_.store(false);
+        std::lock_guard<std::mutex> lock(mutex_);
+        parked_.store(false);
+        cv_.notify_all();
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<size_t> seq{0};
+        Task task;
+        Clock::time_point posted;
+    };
+
+    struct ControlTask {
+        Task task;
+        Clock::time_point posted;
+    };
+
+    /// @brief Marks a Post in progress for as long as it is in scope
+    struct InFlight {
+        explicit InFlight(std::atomic<size_t>& posting) : posting(posting) { posting.fetch_add(1); }
+        ~InFlight() { posting.fetch_sub(1); }
+        std::atomic<size_t>& posting;
+    };
+
+    static constexpr size_t kSpinIterations = 2000;
+    static constexpr size_t kYieldIterations = 50;
+
+    static size_t RoundUpPow2(size_t n) {
+        size_t p = 2;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    static void Backoff(size_t spins) {
+        if (spins < kSpinIterations)
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        else
+            std::this_thread::yield();
+    }
+
+    /// @brief Ring slots in use, producers may see it slightly stale
+    inline size_t Queued() const {
+        return enqueue_pos_.load(std::memory_order_relaxed) - dequeued_.load(std::memory_order_relaxed);
+    }
+
+    void WakeAll() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        parked_.store(false);
+        cv_.notify_all();
+    }
+
+    /// @brief Moves the next task out, control first, false when both are empty
+    bool TryPop(Task& task, Clock::time_point& posted) {
+        if (control_pending_.load(std::memory_order_acquire) > 0) {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            posted = control_.front().posted;
+            task = std::move(control_.front().task);
+            control_.pop_front();
+            control_pending_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        Slot& slot = slots_[dequeue_pos_ & mask_];
+        if (slot.seq.load(std::memory_order_acquire) != dequeue_pos_ + 1)
+            return false;
+        posted = slot.posted;
+        task = std::move(slot.task);
+        slot.seq.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_pos_;
+        dequeued_.store(dequeue_pos_, std::memory_order_relaxed);
+        return true;
+    }
+
+    inline bool Ready() const {
+        return control_pending_.load(std::memory_order_acquire) > 0 ||
+               slots_[dequeue_pos_ & mask_].seq.load(std::memory_order_acquire) == dequeue_pos_ + 1;
+    }
+
+    void Wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            parked_.store(false, std::memory_order_relaxed);
+            cv_.notify_one();
+        }
+    }
+
+    void Run() {
+        Task task;
+        Clock::time_point posted;
+        size_t idle = 0;
+        while (true) {
+            if (TryPop(task, posted)) {
+                if (Discarding()) {
+                    CountDropped();
+                } else {
+                    CountRun(posted);
+                    task();
+                }
+                task.Reset();
+                RunTickIfDue(Clock::now());
+                idle = 0;
+                continue;
+            }
+            // Stop and Shutdown both finish what is queued first, and the
+            // posts already past their Closed() check
+            if (!running_.load() || Closed()) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (posting_.load() == 0 && !Ready())
+                    break;
+                Backoff(idle++);
+                continue;
+            }
+            RunTickIfDue(Clock::now());
+
+            // spin, then yield, then park until a producer wakes us
+            if (idle < kSpinIterations + kYieldIterations) {
+                Backoff(idle++);
+                continue;
+            }
+            parked_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (Ready()) {
+                parked_.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_until(lock, std::min(NextTick(), Clock::now() + std::chrono::milliseconds(50)), [&] {
+                return !parked_.load(std::memory_order_relaxed) || !running_.load() || Closed();
+            });
+            parked_.store(false, std::memory_order_relaxed);
+            idle = 0;
+        }
+        Exiting();
+    }
+
+    const size_t mask_;
+    std::vector<Slot> slots_;
+    /* ring slots telemetry may occupy */
+    const size_t telemetry_limit_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) size_t dequeue_pos_{0};
+    /* dequeue_pos_ published for Queued() */
+    std::atomic<size_t> dequeued_{0};
+    std::atomic<size_t> control_pending_{0};
+    /* Posts between their Closed() check and their slot, see InFlight */
+    std::atomic<size_t> posting_{0};
+    std::mutex control_mutex_;
+    std::deque<ControlTask> control_;
+    std::atomic<bool> parked_{false};
+    std::atomic<bool> running_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+};
+
+#endif  // CLARKESIM_SRC_COMMON_EXECUTOR_H_
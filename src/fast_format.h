@@ -0,0 +1,152 @@
+#ifndef CLARKESIM_SRC_COMMON_FAST_FORMAT_H_
+#define CLARKESIM_SRC_COMMON_FAST_FORMAT_H_
+
+#include <fmt/format.h>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+/// @brief Allocation free number formatting for telemetry cells
+///
+/// FormatFixed<P> matches fmt's "{:.Pf}" for the values telemetry carries,
+/// but with the precision fixed at compile time: the value is scaled to an
+/// integer once and its digits are emitted two at a time from a table, no
+/// format string is parsed. Values it cannot place exactly (non-finite,
+/// too large, or a rounding tie) go through fmt so the text never differs.
+namespace fast_format {
+
+/// @brief Longest text FormatFixed and FormatInt produce on the fast path
+constexpr size_t kMaxCellChars = 24;
+
+constexpr char kDigitPairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+constexpr uint64_t Pow10(int n) { return n == 0 ? 1 : 10 * Pow10(n - 1); }
+
+/// @brief Writes the decimal digits of v ending at end, returns the first char
+inline char* WriteDigitsBackward(uint64_t v, char* end) {
+    while (v >= 100) {
+        end -= 2;
+        std::memcpy(end, kDigitPairs + (v % 100) * 2, 2);
+        v /= 100;
+    }
+    if (v >= 10) {
+        end -= 2;
+        std::memcpy(end, kDigitPairs + v * 2, 2);
+    } else {
+        *--end = static_cast<char>('0' + v);
+    }
+    return end;
+}
+
+/// @brief Copies at most size bytes of [first, last) to buf, returns the full length
+inline size_t Emit(const char* first, const char* last, char* buf, size_t size) {
+    size_t len = static_cast<size_t>(last - first);
+    std::memcpy(buf, first, len < size ? len : size);
+    return len;
+}
+
+/// @brief Same text as fmt::format("{}", v), returns its length
+inline size_t FormatInt(int64_t v, char* buf, size_t size) {
+    char tmp[kMaxCellChars];
+    char* end = tmp + sizeof(tmp);
+    uint64_t magnitude = v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+    char* first = WriteDigitsBackward(magnitude, end);
+    if (v < 0) *--first = '-';
+    return Emit(first, end, buf, size);
+}
+
+/// @brief Same text as fmt::format("{:.Pf}", v), returns its length
+/// Text longer than size is cut, like fmt::format_to_n
+template<int P>
+inline size_t FormatFixed(double v, char* buf, size_t size) {
+    static_assert(P >= 0 && P <= 9, "FormatFixed supports 0 to 9 decimals");
+    constexpr uint64_t kScale = Pow10(P);
+    // beyond 2^53 the scaled value is no longer an exact integer
+    constexpr double kLimit = 9007199254740992.0 / static_cast<double>(kScale);
+
+    double magnitude = std::fabs(v);
+    if (!(magnitude < kLimit))  // also NaN
+        return fmt::format_to_n(buf, size, "{:.{}f}", v, P).size;
+    double scaled = magnitude * static_cast<double>(kScale);
+    double whole = std::floor(scaled);
+    double frac = scaled - whole;
+    // the product may be off by half an ulp, a fraction that close to a
+    // tie could round either way, fmt rounds the exact binary value
+    if (std::fabs(frac - 0.5) <= 1e-9 + scaled * 2.3e-16)
+        return fmt::format_to_n(buf, size, "{:.{}f}", v, P).size;
+    uint64_t fixed = static_cast<uint64_t>(whole) + (frac > 0.5 ? 1 : 0);
+
+    char tmp[kMaxCellChars];
+    char* end = tmp + sizeof(tmp);
+    char* first = end;
+    if constexpr (P > 0) {
+        uint64_t decimals = fixed % kScale;
+        for (int d = 0; d < P; ++d) {
+            *--first = static_cast<char>('0' + decimals % 10);
+            decimals /= 10;
+        }
+        *--first = '.';
+    }
+    first = WriteDigitsBackward(fixed / kScale, first);
+    if (std::signbit(v)) *--first = '-';
+    return Emit(first, end, buf, size);
+}
+
+/// @brief FormatFixed with the precision picked at run time (0 to 9)
+inline size_t FormatFixed(int precision, double v, char* buf, size_t size) {
+    switch (precision) {
+        case 0: return FormatFixed<0>(v, buf, size);
+        case 1: return FormatFixed<1>(v, buf, size);
+        case 2: return FormatFixed<2>(v, buf, size);
+        case 3: return FormatFixed<3>(v, buf, size);
+        case 4: return FormatFixed<4>(v, buf, size);
+        case 5: return FormatFixed<5>(v, buf, size);
+        case 6: return FormatFixed<6>(v, buf, size);
+        case 7: return FormatFixed<7>(v, buf, size);
+        case 8: return FormatFixed<8>(v, buf, size);
+        case 9: return FormatFixed<9>(v, buf, size);
+        default: return fmt::format_to_n(buf, size, "{:.{}f}", v, precision).size;
+    }
+}
+
+/// @brief Precision of a "{:.Nf}" spec with a single digit N, -1 for any other spec
+inline int FixedPrecision(std::string_view spec) {
+    if (spec.size() == 6 && spec.compare(0, 3, "{:.") == 0 && spec[3] >= '0' && spec[3] <= '9' &&
+        spec.compare(4, 2, "f}") == 0)
+        return spec[3] - '0';
+    return -1;
+}
+
+/// @brief Formats a whole row back to back into buf without allocating
+/// @param ends receives the end offset of each cell, cell n is
+/// [n ? ends[n-1] : 0, ends[n])
+/// @return bytes used, cells that do not fit entirely are dropped
+template<int P, typename T>
+inline size_t FormatRow(const T* values, size_t count, char* buf, size_t size, size_t* ends) {
+    size_t used = 0;
+    for (size_t n = 0; n < count; ++n) {
+        char cell[kMaxCellChars];
+        size_t len;
+        if constexpr (std::is_integral_v<T>)
+            len = FormatInt(static_cast<int64_t>(values[n]), cell, sizeof(cell));
+        else
+            len = FormatFixed<P>(static_cast<double>(values[n]), cell, sizeof(cell));
+        len = len < sizeof(cell) ? len : sizeof(cell);
+        if (used + len > size)
+            len = 0;
+        std::memcpy(buf + used, cell, len);
+        used += len;
+        ends[n] = used;
+    }
+    return used;
+}
+
+}  // namespace fast_format
+
+#endif  // CLARKESIM_SRC_COMMON_FAST_FORMAT_H_
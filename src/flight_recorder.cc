@@ -0,0 +1,255 @@
+#include "flight_recorder.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+using namespace flight_log;
+
+FlightRecorder::FlightRecorder(Options options)
+    : options_(std::move(options)) {
+    options_.block_rows = std::max<size_t>(options_.block_rows, 1);
+    // a segment must hold at least one full-width block, the largest schema
+    // written with it and some statuses
+    options_.segment_bytes = std::max(options_.segment_bytes,
+        sizeof(SegmentHeader) + BlockBytes(options_.block_rows, kMaxTelemetryColumns) +
+        kMaxSchemaBytes + (64u << 10));
+    OpenSegment();
+}
+
+FlightRecorder::~FlightRecorder(){
+    Flush();
+    CloseSegment();
+}
+
+int64_t FlightRecorder::Now(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void FlightRecorder::RecordSample(const TelemetrySample& sample, const TelemetrySchema& schema,
+                                  int64_t time_ns){
+    if (!ok())
+        return;
+    if (sample.schema >= blocks_.size())
+        blocks_.resize(sample.schema + 1);
+    Block& block = blocks_[sample.schema];
+    if (block.schema == nullptr){
+        // sized once per schema, the hot path below never allocates
+        block.schema = &schema;
+        block.columns = static_cast<uint32_t>(std::min(schema.columns.size(), kMaxTelemetryColumns));
+        block.time_ns.resize(options_.block_rows);
+        block.int_mask.resize(options_.block_rows);
+        block.values.resize(options_.block_rows * block.columns);
+    }
+
+    // a block belongs to one table, a schema shared by tables splits it
+    if (block.rows > 0 && block.table != sample.table)
+        FlushBlock(sample.schema, block);
+    block.table = sample.table;
+
+    uint32_t r = block.rows++;
+    block.time_ns[r] = time_ns;
+    block.int_mask[r] = sample.int_mask;
+    for (uint32_t c = 0; c < block.columns; ++c)
+        block.values[c * options_.block_rows + r] =
+            (c < sample.count) ? sample.values[c] : TelemValue{0.0};
+
+    if (block.rows == options_.block_rows)
+        FlushBlock(sample.schema, block);
+}
+
+void FlightRecorder::RecordStatus(StatusEvent event, const IStatusPrint& status, int64_t time_ns){
+    if (!ok())
+        return;
+    Flush();
+
+    std::string_view header = status.header.view();
+    auto header_len = static_cast<uint16_t>(std::min<size_t>(header.size(), UINT16_MAX));
+    auto data_len = static_cast<uint16_t>(std::min<size_t>(status.data.size(), UINT16_MAX));
+    size_t bytes = Align8(sizeof(StatusRecord) + header_len + data_len);
+    uint8_t* out = Reserve(bytes);
+    if (out == nullptr)
+        return;
+
+    StatusRecord rec{};
+    rec.hdr = {kStatusRecord, 0, static_cast<uint32_t>(bytes)};
+    rec.time_ns = time_ns;
+    rec.id = status.id;
+    rec.event = event;
+    rec.level = static_cast<uint16_t>(status.level);
+    rec.header_len = header_len;
+    rec.data_len = data_len;
+    std::memcpy(out, &rec, sizeof(rec));
+    std::memcpy(out + sizeof(rec), header.data(), header_len);
+    std::memcpy(out + sizeof(rec) + header_len, status.data.data(), data_len);
+    Commit(bytes);
+}
+
+void FlightRecorder::Flush(){
+    for (uint32_t handle = 0; handle < blocks_.size(); ++handle)
+        if (blocks_[handle].rows > 0)
+            FlushBlock(handle, blocks_[handle]);
+}
+
+void FlightRecorder::FlushBlock(uint32_t handle, Block& block){
+    size_t rows = block.rows;
+    size_t bytes = BlockBytes(rows, block.columns);
+    // room for the schema too, so a rotation never splits them
+    if (Reserve(SchemaBytes(*block.schema) + bytes) == nullptr){
+        // the rows are lost, the block starts over instead of overflowing
+        ReportDroppedBlock(rows);
+        block.rows = 0;
+        return;
+    }
+    if (handle >= written_schemas_.size() || !written_schemas_[handle])
+        WriteSchema(handle, *block.schema);
+    uint8_t* out = base_ + used_;
+
+    BlockRecord rec{};
+    rec.hdr = {kBlockRecord, 0, static_cast<uint32_t>(bytes)};
+    rec.schema = handle;
+    rec.rows = static_cast<uint32_t>(rows);
+    rec.columns = block.columns;
+    rec.table = block.table;
+    rec.first_ns = block.time_ns[0];
+    rec.last_ns = block.time_ns[rows - 1];
+    std::memcpy(out, &rec, sizeof(rec));
+    out += sizeof(rec);
+    std::memcpy(out, block.time_ns.data(), rows * sizeof(int64_t));
+    out += rows * sizeof(int64_t);
+    std::memcpy(out, block.int_mask.data(), rows * sizeof(uint32_t));
+    out += Align8(rows * sizeof(uint32_t));
+    for (uint32_t c = 0; c < block.columns; ++c){
+        std::memcpy(out, &block.values[c * options_.block_rows], rows * sizeof(TelemValue));
+        out += rows * sizeof(TelemValue);
+    }
+    Commit(bytes);
+    block.rows = 0;
+}
+
+size_t FlightRecorder::SchemaBytes(const TelemetrySchema& schema){
+    size_t columns = std::min(schema.columns.size(), kMaxTelemetryColumns);
+    size_t bytes = sizeof(SchemaRecord);
+    for (size_t c = 0; c < columns; ++c)
+        bytes += 4 + std::min(schema.columns[c].title.size(), kMaxTitleBytes);
+    return Align8(bytes);
+}
+
+void FlightRecorder::WriteSchema(uint32_t handle, const TelemetrySchema& schema){
+    uint32_t columns = static_cast<uint32_t>(std::min(schema.columns.size(), kMaxTelemetryColumns));
+    size_t bytes = SchemaBytes(schema);
+
+    uint8_t* out = Reserve(bytes);
+    if (out == nullptr)
+        return;
+    std::memset(out, 0, bytes);
+    SchemaRecord rec{};
+    rec.hdr = {kSchemaRecord, 0, static_cast<uint32_t>(bytes)};
+    rec.schema = handle;
+    rec.precision = schema.precision;
+    rec.columns = columns;
+    std::memcpy(out, &rec, sizeof(rec));
+    uint8_t* p = out + sizeof(rec);
+    for (uint32_t c = 0; c < columns; ++c){
+        const Column& col = schema.columns[c];
+        auto len = static_cast<uint16_t>(std::min(col.title.size(), kMaxTitleBytes));
+        p[0] = static_cast<uint8_t>(col.align);
+        p[1] = static_cast<uint8_t>(col.aggregate);
+        std::memcpy(p + 2, &len, sizeof(len));
+        std::memcpy(p + 4, col.title.data(), len);
+        p += 4 + len;
+    }
+    Commit(bytes);
+
+    if (handle >= written_schemas_.size())
+        written_schemas_.resize(handle + 1, false);
+    written_schemas_[handle] = true;
+}
+
+uint8_t* FlightRecorder::Reserve(size_t bytes){
+    if (base_ != nullptr && used_ + bytes <= options_.segment_bytes)
+        return base_ + used_;
+    // rotate, the new segment describes its schemas again
+    CloseSegment();
+    if (!OpenSegment() || used_ + bytes > options_.segment_bytes)
+        return nullptr;
+    return base_ + used_;
+}
+
+void FlightRecorder::Commit(size_t bytes){
+    used_ += bytes;
+    reinterpret_cast<SegmentHeader*>(base_)->used_bytes = used_;
+}
+
+bool FlightRecorder::OpenSegment(){
+    if (!first_segment_)
+        ++segment_index_;
+    first_segment_ = false;
+
+    std::string path = SegmentPath(options_.path_prefix, segment_index_);
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0){
+        ReportFailure("open");
+        return false;
+    }
+    if (::ftruncate(fd_, static_cast<off_t>(options_.segment_bytes)) != 0){
+        ReportFailure("ftruncate");
+        CloseSegment();
+        return false;
+    }
+    void* map = ::mmap(nullptr, options_.segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED){
+        ReportFailure("mmap");
+        CloseSegment();
+        return false;
+    }
+    base_ = static_cast<uint8_t*>(map);
+
+    SegmentHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.segment_index = segment_index_;
+    header.created_ns = Now();
+    header.used_bytes = sizeof(SegmentHeader);
+    std::memcpy(base_, &header, sizeof(header));
+    used_ = sizeof(SegmentHeader);
+    written_schemas_.assign(written_schemas_.size(), false);
+    return true;
+}
+
+void FlightRecorder::CloseSegment(){
+    if (base_ != nullptr){
+        ::munmap(base_, options_.segment_bytes);
+        base_ = nullptr;
+        // trim the preallocated tail, readers stop at used_bytes anyway
+        if (::ftruncate(fd_, static_cast<off_t>(used_)) != 0)
+            ReportFailure("trim");
+    }
+    if (fd_ >= 0){
+        ::close(fd_);
+        fd_ = -1;
+    }
+    used_ = 0;
+}
+
+void FlightRecorder::ReportFailure(const char* call){
+    int error = errno;
+    if (failure_reported_ || !options_.logger)
+        return;
+    failure_reported_ = true;
+    options_.logger->error("recorder,{},\"{}: {}\"", call,
+                           SegmentPath(options_.path_prefix, segment_index_), std::strerror(error));
+}
+
+void FlightRecorder::ReportDroppedBlock(size_t rows){
+    if (drop_reported_ || !options_.logger)
+        return;
+    drop_reported_ = true;
+    options_.logger->error("recorder,block dropped,\"{} rows lost, no room in {}\"", rows,
+                           SegmentPath(options_.path_prefix, segment_index_));
+}
@@ -0,0 +1,182 @@
+#ifndef CLARKESIM_SRC_COMMON_FLIGHT_RECORDER_H_
+#define CLARKESIM_SRC_COMMON_FLIGHT_RECORDER_H_
+
+#include <spdlog/spdlog.h>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "console_base.h"
+
+/// @brief On-disk layout of a flight log segment (native endianness)
+///
+/// A log is a series of segment files "<prefix>.<NNNN>.ccrec". Each one
+/// starts with a SegmentHeader followed by 8-byte aligned records. Every
+/// segment repeats the schema records it uses, so each file describes
+/// itself. Telemetry is stored in blocks, column by column:
+///     BlockRecord | int64 time_ns[rows] | uint32 int_mask[rows] (8-aligned)
+///                 | TelemValue column0[rows] | ... | columnN[rows]
+namespace flight_log {
+
+constexpr char kMagic[8] = {'C', 'C', 'F', 'L', 'T', 'L', 'O', 'G'};
+constexpr uint32_t kVersion = 1;
+
+enum RecordType : uint16_t {
+    kSchemaRecord = 1,
+    kBlockRecord = 2,
+    kStatusRecord = 3
+};
+
+/// @brief What happened to the status carried by a StatusRecord
+enum StatusEvent : uint16_t {
+    kStatusNew = 0,
+    kStatusPollStart = 1,
+    kStatusPollStop = 2
+};
+
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t segment_index;
+    int64_t created_ns;
+    uint64_t used_bytes; /* header included, updated after every record */
+    uint8_t reserved[32];
+};
+
+struct RecordHeader {
+    uint16_t type;
+    uint16_t reserved;
+    uint32_t size; /* payload + header, multiple of 8 */
+};
+
+/// @brief Followed by columns x {uint8 align, uint8 aggregate, uint16 len, title}
+struct SchemaRecord {
+    RecordHeader hdr;
+    uint32_t schema;
+    int32_t precision;
+    uint32_t columns;
+    uint32_t reserved;
+};
+
+struct BlockRecord {
+    RecordHeader hdr;
+    uint32_t schema;
+    uint32_t rows;
+    uint32_t columns;
+    uint32_t table; /* TableId shared by every row of the block */
+    int64_t first_ns;
+    int64_t last_ns;
+};
+
+/// @brief Followed by header_len + data_len bytes of text
+struct StatusRecord {
+    RecordHeader hdr;
+    int64_t time_ns;
+    uint64_t id;
+    uint16_t event;
+    uint16_t level;
+    uint16_t header_len;
+    uint16_t data_len;
+};
+
+constexpr size_t Align8(size_t n) { return (n + 7) & ~size_t{7}; }
+
+/// @brief Longest column title recorded, longer ones are cut
+constexpr size_t kMaxTitleBytes = 255;
+/// @brief Bytes of the largest schema record
+constexpr size_t kMaxSchemaBytes =
+    Align8(sizeof(SchemaRecord) + kMaxTelemetryColumns * (4 + kMaxTitleBytes));
+
+/// @brief Bytes of a block record holding rows x columns values
+constexpr size_t BlockBytes(size_t rows, size_t columns) {
+    return sizeof(BlockRecord) + rows * sizeof(int64_t) + Align8(rows * sizeof(uint32_t)) +
+           rows * columns * sizeof(TelemValue);
+}
+
+inline std::string SegmentPath(const std::string& prefix, uint32_t index) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%04u.ccrec", index);
+    return prefix + suffix;
+}
+
+}  // namespace flight_log
+
+/// @brief Appends telemetry and status events to memory-mapped log segments
+///
+/// Samples are buffered per schema into columnar blocks and copied into the
+/// mapped segment when a block fills, so recording a sample is a few stores
+/// and never a syscall. Syscalls only happen when a segment is opened or
+/// rotated (every segment_bytes). Not thread-safe, call from the console
+/// executor like the rest of ConsoleTablePrinter.
+class FlightRecorder {
+public:
+    struct Options {
+        std::string path_prefix;
+        size_t segment_bytes{64u << 20};
+        size_t block_rows{256};
+        /* Told about the first failed syscall, recording stops silently otherwise */
+        std::shared_ptr<spdlog::logger> logger{};
+    };
+
+    explicit FlightRecorder(Options options);
+    ~FlightRecorder();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    /// @brief Buffers a sample, its schema is written on first use per segment
+    void RecordSample(const TelemetrySample& sample, const TelemetrySchema& schema, int64_t time_ns);
+
+    /// @brief Writes a status event, pending blocks go first to keep time order
+    void RecordStatus(flight_log::StatusEvent event, const IStatusPrint& status, int64_t time_ns);
+
+    /// @brief Copies every pending block into the mapped segment
+    void Flush();
+
+    /// @brief False once a segment could not be created or mapped
+    inline bool ok() const { return base_ != nullptr; }
+    inline uint32_t segments() const { return segment_index_ + 1; }
+
+    /// @brief Wall clock timestamp used for records
+    static int64_t Now();
+
+private:
+    struct Block {
+        const TelemetrySchema* schema{nullptr};
+        uint32_t columns{};
+        uint32_t rows{};
+        TableId table{kDefaultTable};
+        std::vector<int64_t> time_ns;
+        std::vector<uint32_t> int_mask;
+        std::vector<TelemValue> values; /* columnar, column c at c * block_rows */
+    };
+
+    void FlushBlock(uint32_t handle, Block& block);
+    void WriteSchema(uint32_t handle, const TelemetrySchema& schema);
+    static size_t SchemaBytes(const TelemetrySchema& schema);
+    /// @brief Returns space for a record, rotating the segment when full
+    uint8_t* Reserve(size_t bytes);
+    void Commit(size_t bytes);
+    bool OpenSegment();
+    void CloseSegment();
+    /// @brief Logs a failed syscall on the current segment, the first one only
+    void ReportFailure(const char* call);
+    /// @brief Logs a block that found no room, the first one only
+    void ReportDroppedBlock(size_t rows);
+
+    Options options_;
+    std::vector<Block> blocks_{};
+    /* schemas already described in the current segment */
+    std::vector<bool> written_schemas_{};
+
+    int fd_{-1};
+    uint8_t* base_{nullptr};
+    size_t used_{0};
+    uint32_t segment_index_{0};
+    bool first_segment_{true};
+    bool failure_reported_{false};
+    bool drop_reported_{false};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_FLIGHT_RECORDER_H_
@@ -0,0 +1,256 @@
+#include "flight_replay.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+using namespace flight_log;
+
+namespace {
+
+/// @brief Parses the columns of a schema record, false when one of them
+/// runs past the end of the record
+bool ReadSchema(const uint8_t* rec, size_t record_bytes, TelemetrySchema& schema){
+    SchemaRecord sr;
+    std::memcpy(&sr, rec, sizeof(sr));
+    schema.precision = sr.precision;
+    size_t offset = sizeof(sr);
+    for (uint32_t c = 0; c < sr.columns; ++c){
+        if (offset + 4 > record_bytes)
+            return false;
+        uint16_t len;
+        std::memcpy(&len, rec + offset + 2, sizeof(len));
+        if (offset + 4 + len > record_bytes)
+            return false;
+        schema.columns.push_back({std::string(reinterpret_cast<const char*>(rec + offset + 4), len),
+                                  static_cast<ColumnAlign>(rec[offset]),
+                                  static_cast<Aggregate>(rec[offset + 1])});
+        offset += 4 + len;
+    }
+    return true;
+}
+
+/// @brief The rows x columns payload of a block lies within its record
+bool BlockFits(const BlockRecord& block, size_t record_bytes){
+    // both counts are bounded first, BlockBytes cannot overflow then
+    if (block.rows > record_bytes / (sizeof(int64_t) + sizeof(uint32_t)) ||
+        block.columns > record_bytes / sizeof(TelemValue))
+        return false;
+    return BlockBytes(block.rows, block.columns) <= record_bytes;
+}
+
+/// @brief Smallest record of a type, 0 for types replay does not read
+size_t MinRecordBytes(uint16_t type){
+    switch (type){
+        case kSchemaRecord: return sizeof(SchemaRecord);
+        case kBlockRecord:  return sizeof(BlockRecord);
+        case kStatusRecord: return sizeof(StatusRecord);
+    }
+    return 0;
+}
+
+}  // namespace
+
+FlightLog::~FlightLog(){
+    for (auto& segment : segments_)
+        ::munmap(const_cast<uint8_t*>(segment.base), segment.size);
+}
+
+bool FlightLog::Open(const std::string& prefix){
+    for (uint32_t i = 0; MapSegment(SegmentPath(prefix, i)); ++i)
+        IndexSegment(i);
+    return !segments_.empty();
+}
+
+bool FlightLog::MapSegment(const std::string& path){
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st{};
+    bool ok = ::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(SegmentHeader);
+    void* map = ok ? ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    auto base = static_cast<const uint8_t*>(map);
+    if (std::memcmp(base, kMagic, sizeof(kMagic)) != 0){
+        ::munmap(map, st.st_size);
+        return false;
+    }
+    // sequential scan of the records, the kernel can read ahead
+    ::madvise(map, st.st_size, MADV_SEQUENTIAL);
+    segments_.push_back({base, static_cast<size_t>(st.st_size)});
+    return true;
+}
+
+void FlightLog::IndexSegment(uint32_t segment){
+    const Segment& seg = segments_[segment];
+    SegmentHeader header;
+    std::memcpy(&header, seg.base, sizeof(header));
+    // a crashed recorder leaves a preallocated tail, used_bytes marks the end
+    size_t end = std::min<size_t>(header.used_bytes, seg.size);
+    bytes_ += end;
+
+    size_t offset = sizeof(SegmentHeader);
+    while (offset + sizeof(RecordHeader) <= end){
+        const uint8_t* rec = seg.base + offset;
+        RecordHeader hdr;
+        std::memcpy(&hdr, rec, sizeof(hdr));
+        if (hdr.size < sizeof(RecordHeader) || offset + hdr.size > end)
+            break;
+        // a record whose payload does not fit its size is skipped, so
+        // replay only ever decodes records checked here
+        if (hdr.size < MinRecordBytes(hdr.type)){
+            offset += hdr.size;
+            continue;
+        }
+
+        if (hdr.type == kSchemaRecord){
+            SchemaRecord sr;
+            std::memcpy(&sr, rec, sizeof(sr));
+            TelemetrySchema schema;
+            if (schemas_.count(sr.schema) == 0 && ReadSchema(rec, hdr.size, schema))
+                schemas_.emplace(sr.schema, std::move(schema));
+        } else if (hdr.type == kBlockRecord || hdr.type == kStatusRecord){
+            int64_t first, last;
+            bool fits;
+            if (hdr.type == kBlockRecord){
+                BlockRecord br;
+                std::memcpy(&br, rec, sizeof(br));
+                fits = BlockFits(br, hdr.size);
+                first = br.first_ns;
+                last = br.last_ns;
+            } else {
+                StatusRecord st;
+                std::memcpy(&st, rec, sizeof(st));
+                fits = sizeof(st) + st.header_len + st.data_len <= hdr.size;
+                first = last = st.time_ns;
+            }
+            if (!fits){
+                offset += hdr.size;
+                continue;
+            }
+            end_ns_ = std::max(end_ns_, last);
+            index_.push_back({segment, hdr.type, offset, first, end_ns_});
+        }
+        offset += hdr.size;
+    }
+}
+
+const TelemetrySchema* FlightLog::FindSchema(uint32_t handle) const{
+    auto it = schemas_.find(handle);
+    return it == schemas_.end() ? nullptr : &it->second;
+}
+
+size_t FlightLog::Seek(int64_t time_ns) const{
+    auto it = std::lower_bound(index_.begin(), index_.end(), time_ns,
+        [](const Entry& e, int64_t t){ return e.reach_ns < t; });
+    return static_cast<size_t>(it - index_.begin());
+}
+
+SchemaHandle FlightReplay::MapSchema(IConsole& console, uint32_t recorded){
+    auto it = schema_map_.find(recorded);
+    if (it != schema_map_.end())
+        return it->second;
+    const TelemetrySchema* schema = log_.FindSchema(recorded);
+    SchemaHandle handle = schema ? console.registerSchema(schema->columns, schema->precision)
+                                 : console.registerSchema({}, 2);
+    schema_map_.emplace(recorded, handle);
+    return handle;
+}
+
+void FlightReplay::ReplayStatus(ThreadManager& tm, IConsole& console, const uint8_t* record){
+    StatusRecord rec;
+    std::memcpy(&rec, record, sizeof(rec));
+    const char* text = reinterpret_cast<const char*>(record + sizeof(rec));
+    IStatusPrint status{static_cast<ConsoleLevels>(rec.level),
+                        std::string_view(text, rec.header_len),
+                        std::string_view(text + rec.header_len, rec.data_len)};
+
+    uint64_t recorded_id = rec.id;
+    auto ids = status_ids_;
+    switch (rec.event){
+        case kStatusNew:
+            tm.PostStatus(console, std::move(status));
+            break;
+        case kStatusPollStart:
+            tm.PollStatus(console, std::move(status), [ids, recorded_id](size_t id){
+                (*ids)[recorded_id] = id;
+            });
+            break;
+        case kStatusPollStop:
+            tm.PostUpdate(console, [ids, recorded_id, status = std::move(status)](IConsole& con){
+                auto it = ids->find(recorded_id);
+                if (it != ids->end())
+                    con.stopPolling(it->second, status);
+            });
+            break;
+    }
+}
+
+FlightReplay::Stats FlightReplay::Run(ThreadManager& tm, IConsole& console, const Options& options){
+    using Clock = std::chrono::steady_clock;
+    Stats stats;
+    const auto& index = log_.index();
+    auto wall_start = Clock::now();
+    int64_t seek_ns = log_.start_ns() + static_cast<int64_t>(options.seek_s * 1e9);
+    size_t first = log_.Seek(seek_ns);
+
+    // statuses before the seek point still belong on screen, unpaced
+    for (size_t i = 0; i < first; ++i)
+        if (index[i].type == kStatusRecord){
+            ReplayStatus(tm, console, log_.Record(index[i]));
+            ++stats.statuses;
+        }
+
+    int64_t log_start = std::max(seek_ns, log_.start_ns());
+    auto pace = [&](int64_t time_ns){
+        if (options.speed <= 0)
+            return;
+        auto offset = std::chrono::duration<double>((time_ns - log_start) / 1e9 / options.speed);
+        auto target = wall_start + std::chrono::duration_cast<Clock::duration>(offset);
+        if (target - Clock::now() > std::chrono::milliseconds(1))
+            std::this_thread::sleep_until(target);
+    };
+
+    for (size_t i = first; i < index.size(); ++i){
+        const uint8_t* record = log_.Record(index[i]);
+        if (index[i].type == kStatusRecord){
+            pace(index[i].time_ns);
+            ReplayStatus(tm, console, record);
+            ++stats.statuses;
+            continue;
+        }
+
+        // rows and columns fit the record, IndexSegment checked them
+        BlockRecord block;
+        std::memcpy(&block, record, sizeof(block));
+        const auto* time_ns = reinterpret_cast<const int64_t*>(record + sizeof(block));
+        const auto* int_mask = reinterpret_cast<const uint32_t*>(time_ns + block.rows);
+        const auto* columns = reinterpret_cast<const TelemValue*>(
+            reinterpret_cast<const uint8_t*>(int_mask) + Align8(block.rows * sizeof(uint32_t)));
+
+        TelemetrySample sample;
+        sample.schema = MapSchema(console, block.schema);
+        sample.count = std::min<uint32_t>(block.columns, kMaxTelemetryColumns);
+        sample.table = block.table;
+        for (uint32_t r = 0; r < block.rows; ++r){
+            if (time_ns[r] < seek_ns)
+                continue;
+            pace(time_ns[r]);
+            sample.int_mask = int_mask[r];
+            for (uint32_t c = 0; c < sample.count; ++c)
+                sample.values[c] = columns[c * block.rows + r];
+            tm.PostSample(console, sample);
+            ++stats.samples;
+        }
+    }
+    stats.wall_s = std::chrono::duration<double>(Clock::now() - wall_start).count();
+    return stats;
+}
@@ -0,0 +1,105 @@
+#ifndef CLARKESIM_SRC_COMMON_FLIGHT_REPLAY_H_
+#define CLARKESIM_SRC_COMMON_FLIGHT_REPLAY_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "console_base.h"
+#include "flight_recorder.h"
+#include "thread_manager.h"
+
+/// @brief Read-only, memory-mapped view of the segments written by FlightRecorder
+///
+/// Open walks the record headers once (records are skipped by size, block
+/// payloads are never touched) to collect the schemas and a sparse time
+/// index: one entry per block or status record, not per sample. Records
+/// whose counts do not fit their size (a torn or corrupt segment) are left
+/// out of the index, so Record() only returns payloads that are in bounds.
+class FlightLog {
+public:
+    struct Entry {
+        uint32_t segment;
+        uint32_t type;   /* flight_log::RecordType */
+        size_t offset;   /* of the record header in its segment */
+        int64_t time_ns; /* first sample of a block, time of a status */
+        int64_t reach_ns; /* latest time seen up to this entry, monotonic */
+    };
+
+    FlightLog() = default;
+    ~FlightLog();
+    FlightLog(const FlightLog&) = delete;
+    FlightLog& operator=(const FlightLog&) = delete;
+
+    /// @brief Maps <prefix>.0000.ccrec, .0001, ... until one is missing
+    /// @return false when no valid segment was found
+    bool Open(const std::string& prefix);
+
+    inline const std::vector<Entry>& index() const { return index_; }
+    inline const uint8_t* Record(const Entry& entry) const {
+        return segments_[entry.segment].base + entry.offset;
+    }
+
+    /// @brief Layout recorded for a schema handle, nullptr if never seen
+    const TelemetrySchema* FindSchema(uint32_t handle) const;
+
+    /// @brief First index entry at or after time_ns
+    size_t Seek(int64_t time_ns) const;
+
+    inline int64_t start_ns() const { return index_.empty() ? 0 : index_.front().time_ns; }
+    inline int64_t end_ns() const { return end_ns_; }
+    inline uint64_t bytes() const { return bytes_; }
+
+private:
+    struct Segment {
+        const uint8_t* base;
+        size_t size;
+    };
+
+    bool MapSegment(const std::string& path);
+    void IndexSegment(uint32_t segment);
+
+    std::vector<Segment> segments_{};
+    std::vector<Entry> index_{};
+    std::unordered_map<uint32_t, TelemetrySchema> schemas_{};
+    int64_t end_ns_{0};
+    uint64_t bytes_{0};
+};
+
+/// @brief Feeds a FlightLog back through ThreadManager into an IConsole
+///
+/// Rows and status events take the same path as live producers, so a
+/// replay exercises the executor, the coalescing and the renderer. At max
+/// speed nothing sleeps and the executor's backpressure sets the pace.
+/// Rows keep their recorded TableId, so the console should add its tables
+/// in the same order as the recording run did.
+class FlightReplay {
+public:
+    struct Options {
+        double speed{1.0};  /* playback rate, <= 0 replays at max speed */
+        double seek_s{0.0}; /* start this many seconds into the log */
+    };
+
+    struct Stats {
+        size_t samples{0};
+        size_t statuses{0};
+        double wall_s{0.0};
+    };
+
+    explicit FlightReplay(const FlightLog& log) : log_(log) {}
+
+    Stats Run(ThreadManager& tm, IConsole& console, const Options& options);
+
+private:
+    /// @brief Recorded schema handle -> handle registered on the console
+    SchemaHandle MapSchema(IConsole& console, uint32_t recorded);
+    void ReplayStatus(ThreadManager& tm, IConsole& console, const uint8_t* record);
+
+    const FlightLog& log_;
+    std::unordered_map<uint32_t, SchemaHandle> schema_map_{};
+    /* recorded status id -> console id, only touched on the console thread */
+    std::shared_ptr<std::unordered_map<uint64_t, size_t>> status_ids_{
+        std::make_shared<std::unordered_map<uint64_t, size_t>>()};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_FLIGHT_REPLAY_H_
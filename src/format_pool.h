@@ -0,0 +1,126 @@
+#ifndef CLARKESIM_SRC_COMMON_FORMAT_POOL_H_
+#define CLARKESIM_SRC_COMMON_FORMAT_POOL_H_
+
+#include <semaphore.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// @brief Fork-join pool that formats the lines of one frame
+///
+/// Run(jobs, fn) splits [0, jobs) into one contiguous range per thread, the
+/// caller included. Each thread claims jobs from the front of its own range
+/// and, once it is empty, steals from the ranges of the others; claiming is
+/// a fetch_add, so a job runs exactly once and no lock is taken per job.
+/// Jobs write to slots they own (a table line, a status line), which keeps
+/// the output in order whatever thread formatted it.
+///
+/// Workers park on a counting semaphore between frames: Run posts one
+/// token per worker and waits for as many "done" posts. A worker that
+/// grabs two tokens of the same Run just finds nothing left the second
+/// time, the count still matches.
+class FormatPool {
+public:
+    /// @param threads formatting threads including the caller, at least 1
+    explicit FormatPool(size_t threads)
+        : ranges_(std::max<size_t>(threads, 1)) {
+        ::sem_init(&start_, 0, 0);
+        ::sem_init(&done_, 0, 0);
+        for (size_t i = 1; i < ranges_.size(); ++i)
+            workers_.emplace_back([this, i] { Work(i); });
+    }
+
+    ~FormatPool() {
+        stop_.store(true, std::memory_order_relaxed);
+        for (size_t i = 0; i < workers_.size(); ++i)
+            ::sem_post(&start_);
+        for (auto& worker : workers_)
+            worker.join();
+        ::sem_destroy(&start_);
+        ::sem_destroy(&done_);
+    }
+
+    FormatPool(const FormatPool&) = delete;
+    FormatPool& operator=(const FormatPool&) = delete;
+
+    inline size_t threads() const { return ranges_.size(); }
+
+    /// @brief Calls fn(job) once for each job in [0, jobs), on this thread
+    /// and the workers, and returns when all of them have run
+    /// Not reentrant: one Run at a time (the render thread)
+    template<typename Fn>
+    void Run(size_t jobs, Fn&& fn) {
+        if (jobs == 0)
+            return;
+        if (jobs == 1 || ranges_.size() == 1){
+            for (size_t job = 0; job < jobs; ++job)
+                fn(job);
+            return;
+        }
+        size_t parts = ranges_.size();
+        for (size_t i = 0; i < parts; ++i){
+            ranges_[i].next.store(jobs * i / parts, std::memory_order_relaxed);
+            ranges_[i].end = jobs * (i + 1) / parts;
+        }
+        context_ = &fn;
+        invoke_ = [](void* context, size_t job) { (*static_cast<std::remove_reference_t<Fn>*>(context))(job); };
+        for (size_t i = 0; i < workers_.size(); ++i)
+            ::sem_post(&start_);
+
+        Drain(0);
+        for (size_t i = 0; i < workers_.size(); ++i)
+            Wait(done_);
+    }
+
+private:
+    /// @brief Jobs [next, end) not claimed yet, one cache line per thread
+    struct alignas(64) Range {
+        std::atomic<size_t> next{0};
+        size_t end{0};
+    };
+
+    /// @brief Runs the jobs of range `own`, then steals from the others
+    void Drain(size_t own) {
+        size_t parts = ranges_.size();
+        for (size_t k = 0; k < parts; ++k){
+            Range& range = ranges_[(own + k) % parts];
+            for (;;){
+                size_t job = range.next.fetch_add(1, std::memory_order_relaxed);
+                if (job >= range.end)
+                    break;
+                invoke_(context_, job);
+            }
+        }
+    }
+
+    void Work(size_t own) {
+        for (;;){
+            Wait(start_);
+            if (stop_.load(std::memory_order_relaxed))
+                return;
+            Drain(own);
+            ::sem_post(&done_);
+        }
+    }
+
+    static void Wait(sem_t& semaphore) {
+        while (::sem_wait(&semaphore) != 0 && errno == EINTR) {}
+    }
+
+    std::vector<Range> ranges_;
+    std::vector<std::thread> workers_{};
+    /* The Run in progress, published to the workers by the start post */
+    void* context_{nullptr};
+    void (*invoke_)(void*, size_t){nullptr};
+
+    /* One token per worker and Run, one post back per token taken */
+    sem_t start_;
+    sem_t done_;
+    std::atomic<bool> stop_{false};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_FORMAT_POOL_H_
@@ -0,0 +1,108 @@
+#include "frame_compositor.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+
+std::string& FrameCompositor::NextLine(){
+    if (next_count_ == next_.size())
+        next_.emplace_back();
+    std::string& line = next_[next_count_++];
+    line.clear();
+    return line;
+}
+
+bool FrameCompositor::LineChanged(size_t i) const{
+    return invalidated_ || i >= prev_count_ || next_[i] != prev_[i];
+}
+
+void FrameCompositor::AppendCursorUp(size_t n){
+    if (n > 0) fmt::format_to(std::back_inserter(out_), "\033[{}A", n);
+}
+
+void FrameCompositor::AppendCursorDown(size_t n){
+    if (n > 0) fmt::format_to(std::back_inserter(out_), "\033[{}B", n);
+}
+
+void FrameCompositor::AddEscapes(size_t start){
+    size_t len = out_.size() - start;
+    if (len == 0)
+        return;
+    if (!pieces_.empty() && !pieces_.back().line && pieces_.back().index + pieces_.back().len == start)
+        pieces_.back().len += len;
+    else
+        pieces_.push_back({false, start, len});
+}
+
+const FrameStats& FrameCompositor::Flush(){
+    // the tail of a frame the terminal was too full for goes first
+    sink_->Drain();
+    out_.clear();
+    pieces_.clear();
+    stats_.changed_lines = 0;
+
+    // 1. find the first line that differs, nothing to send if none does
+    size_t first = 0;
+    while (first < next_count_ && !LineChanged(first))
+        ++first;
+    if (first == next_count_ && next_count_ == prev_count_){
+        stats_.bytes = 0;
+        stats_.syscalls = 0;
+        return stats_;
+    }
+
+    // 2. cursor sits below the region, climb to the first changed line
+    size_t start = out_.size();
+    out_ += '\r';
+    AppendCursorUp(prev_count_ - std::min(first, prev_count_));
+    if (invalidated_)
+        out_ += "\033[J";
+    size_t cursor_row = first;
+
+    // 3. repaint changed lines, skip over unchanged ones
+    for (size_t i = first; i < next_count_; ++i){
+        if (!LineChanged(i))
+            continue;
+        AppendCursorDown(i - cursor_row);
+        out_ += "\033[K";
+        AddEscapes(start);
+        if (!next_[i].empty())
+            pieces_.push_back({true, i, next_[i].size()});
+        start = out_.size();
+        out_ += "\r\n";
+        cursor_row = i + 1;
+        ++stats_.changed_lines;
+    }
+
+    // 4. park the cursor below the new region, erase a shrunk tail
+    AppendCursorDown(next_count_ - std::min(cursor_row, next_count_));
+    if (next_count_ < prev_count_)
+        out_ += "\033[J";
+    AddEscapes(start);
+
+    // a skipped frame is never on screen, the next one diffs against prev_
+    if (!WriteOut())
+        return stats_;
+    std::swap(prev_, next_);
+    prev_count_ = next_count_;
+    invalidated_ = false;
+    return stats_;
+}
+
+bool FrameCompositor::WriteOut(){
+    // out_ is complete, its pieces can be pointed at now
+    iov_.clear();
+    for (const Piece& piece : pieces_){
+        const char* base = piece.line ? next_[piece.index].data() : out_.data() + piece.index;
+        iov_.push_back({const_cast<char*>(base), piece.len});
+    }
+    SinkWrite write = sink_->WriteFrame(iov_.data(), iov_.size());
+    stats_.bytes = write.bytes;
+    stats_.syscalls = write.syscalls;
+    stats_.total_bytes += write.bytes;
+    stats_.total_syscalls += write.syscalls;
+    if (write.skipped)
+        ++stats_.skipped_frames;
+    else
+        ++stats_.frames;
+    return !write.skipped;
+}
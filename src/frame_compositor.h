@@ -0,0 +1,99 @@
+#ifndef CLARKESIM_SRC_COMMON_FRAME_COMPOSITOR_H_
+#define CLARKESIM_SRC_COMMON_FRAME_COMPOSITOR_H_
+
+#include <sys/uio.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "output_sink.h"
+
+/// @brief Output accounting for the frames emitted by a FrameCompositor
+struct FrameStats {
+    /* Bytes written by the last emitted frame */
+    size_t bytes{};
+    /* write()/writev() calls issued by the last emitted frame */
+    size_t syscalls{};
+    /* Lines repainted by the last emitted frame */
+    size_t changed_lines{};
+    /* Running totals since construction */
+    size_t total_bytes{};
+    size_t total_syscalls{};
+    size_t frames{};
+    /* Frames the sink could not take, replaced by the next one */
+    size_t skipped_frames{};
+};
+
+/// @brief Off-screen model of the console region below the banner
+///
+/// The caller builds the next frame line by line (NextLine), then Flush
+/// compares it against the last emitted frame and sends only the changed
+/// lines, positioned with relative cursor escapes, as one gather list to
+/// the OutputSink: changed lines are sent from their own buffers, only the
+/// escapes between them are copied.
+/// The cursor is always left on the first column of the row just below
+/// the region so output printed before the first frame (banner) is kept.
+class FrameCompositor {
+public:
+    explicit FrameCompositor(std::shared_ptr<OutputSink> sink) : sink_(std::move(sink)) {}
+
+    /// @brief Starts a new frame, previous line buffers are reused
+    inline void BeginFrame() { next_count_ = 0; }
+
+    /// @brief Appends an empty line to the frame being built
+    /// @return buffer to format the line into (no trailing newline)
+    std::string& NextLine();
+
+    /// @brief Forces the next Flush to repaint every line, after clearing
+    /// the screen below the region (what a resized terminal rewrapped)
+    inline void Invalidate() { invalidated_ = true; }
+
+    /// @brief Emits the difference between the built and the last frame
+    /// A frame the sink skips leaves the model on the last accepted one
+    const FrameStats& Flush();
+
+    /// @brief Writes bytes outside of any frame (e.g. banner, terminal restore)
+    inline void WriteRaw(std::string_view bytes) { sink_->WriteRaw(bytes); }
+    /// @brief OutputSink::WriteDirect, the only call allowed while another
+    /// thread is inside Flush
+    inline void WriteDirect(std::string_view bytes) const { sink_->WriteDirect(bytes); }
+
+    inline const FrameStats& stats() const { return stats_; }
+    inline size_t height() const { return prev_count_; }
+    /// @brief Size of the terminal behind the sink, see OutputSink::Size
+    inline TerminalSize size() const { return sink_->Size(); }
+
+private:
+    bool LineChanged(size_t i) const;
+    void AppendCursorUp(size_t n);
+    void AppendCursorDown(size_t n);
+    /// @brief Adds out_[start..] to the gather list, merged with escapes just before
+    void AddEscapes(size_t start);
+    /// @return false when the sink skipped the frame
+    bool WriteOut();
+
+    /// @brief Escapes in out_ or a whole line of next_
+    struct Piece {
+        bool line;
+        size_t index; /* out_ offset or next_ line */
+        size_t len;
+    };
+
+    std::shared_ptr<OutputSink> sink_;
+    bool invalidated_{false};
+
+    /* Last emitted frame */
+    std::vector<std::string> prev_{};
+    size_t prev_count_{0};
+    /* Frame being built */
+    std::vector<std::string> next_{};
+    size_t next_count_{0};
+    /* Cursor escapes sent by Flush, lines are sent from next_ */
+    std::string out_{};
+    std::vector<Piece> pieces_{};
+    std::vector<iovec> iov_{};
+
+    FrameStats stats_{};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_FRAME_COMPOSITOR_H_
@@ -0,0 +1,80 @@
+#ifndef CLARKESIM_SRC_COMMON_HEADER_REGISTRY_H_
+#define CLARKESIM_SRC_COMMON_HEADER_REGISTRY_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+/// @brief Id of an interned status header
+using HeaderId = uint32_t;
+
+/// @brief Process-wide table of status headers ("Sixdof", "Server", ...)
+///
+/// Every producer interns into the same registry, so a header is stored
+/// once and statuses only carry its id. Looking up a known header takes a
+/// shared lock and does not allocate; entries are never removed, so the
+/// views returned by Name stay valid for the life of the process.
+class HeaderRegistry {
+public:
+    static HeaderRegistry& Shared() {
+        static HeaderRegistry registry;
+        return registry;
+    }
+
+    inline HeaderId Intern(std::string_view name) {
+        {
+            std::shared_lock<std::shared_mutex> lock(m_);
+            auto it = ids_.find(name);
+            if (it != ids_.end())
+                return it->second;
+        }
+        std::scoped_lock<std::shared_mutex> lock(m_);
+        auto it = ids_.find(name);
+        if (it != ids_.end())
+            return it->second;
+        names_.emplace_back(name);
+        auto id = static_cast<HeaderId>(names_.size() - 1);
+        ids_.emplace(names_.back(), id);
+        return id;
+    }
+
+    inline std::string_view Name(HeaderId id) const {
+        std::shared_lock<std::shared_mutex> lock(m_);
+        return id < names_.size() ? std::string_view(names_[id]) : std::string_view();
+    }
+
+private:
+    HeaderRegistry() { names_.emplace_back(); } // id 0 is the empty header
+
+    mutable std::shared_mutex m_{};
+    /* deque: interned strings never move */
+    std::deque<std::string> names_{};
+    std::map<std::string, HeaderId, std::less<>> ids_{{std::string(), 0}};
+};
+
+/// @brief Status header stored as its HeaderRegistry id
+/// Builds implicitly from text so `{INFO, "Server", "..."}` keeps working;
+/// hot producers can intern once and reuse the StatusHeader
+class StatusHeader {
+public:
+    StatusHeader() = default;
+    StatusHeader(const char* name) : id_(HeaderRegistry::Shared().Intern(name ? name : "")) {}
+    StatusHeader(std::string_view name) : id_(HeaderRegistry::Shared().Intern(name)) {}
+    StatusHeader(const std::string& name) : id_(HeaderRegistry::Shared().Intern(name)) {}
+
+    inline HeaderId id() const { return id_; }
+    inline std::string_view view() const { return HeaderRegistry::Shared().Name(id_); }
+    inline operator std::string_view() const { return view(); }
+
+    friend inline bool operator==(StatusHeader a, StatusHeader b) { return a.id_ == b.id_; }
+
+private:
+    HeaderId id_{0};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_HEADER_REGISTRY_H_
@@ -0,0 +1,65 @@
+#ifndef CLARKESIM_SRC_COMMON_INLINE_STRING_H_
+#define CLARKESIM_SRC_COMMON_INLINE_STRING_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/// @brief Fixed-capacity string stored inline, never allocates
+///
+/// Text past Capacity bytes is dropped, cut back to a UTF-8 character
+/// boundary so a truncated line still prints cleanly. Copies are a memcpy,
+/// which keeps structs holding one cheap to capture into executor tasks.
+template<size_t Capacity>
+class InlineString {
+    static_assert(Capacity > 0 && Capacity <= UINT16_MAX, "unsupported InlineString capacity");
+    using Size = std::conditional_t<(Capacity <= UINT8_MAX), uint8_t, uint16_t>;
+
+public:
+    InlineString() = default;
+    InlineString(const char* text) { assign(text ? std::string_view(text) : std::string_view()); }
+    InlineString(std::string_view text) { assign(text); }
+    InlineString(const std::string& text) { assign(text); }
+
+    inline InlineString& operator=(std::string_view text) { assign(text); return *this; }
+
+    inline void assign(std::string_view text) {
+        size_ = 0;
+        append(text);
+    }
+
+    /// @brief Appends as much of text as fits
+    inline InlineString& append(std::string_view text) {
+        size_t n = std::min(text.size(), Capacity - size_);
+        if (n < text.size())
+            while (n > 0 && (static_cast<unsigned char>(text[n]) & 0xC0) == 0x80)
+                --n;
+        std::memcpy(data_ + size_, text.data(), n);
+        size_ = static_cast<Size>(size_ + n);
+        return *this;
+    }
+    inline InlineString& operator+=(std::string_view text) { return append(text); }
+
+    inline void clear() { size_ = 0; }
+
+    inline const char* data() const { return data_; }
+    inline size_t size() const { return size_; }
+    inline bool empty() const { return size_ == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+
+    inline std::string_view view() const { return {data_, size_}; }
+    inline operator std::string_view() const { return view(); }
+    inline std::string str() const { return std::string(data_, size_); }
+
+    friend inline bool operator==(const InlineString& a, std::string_view b) { return a.view() == b; }
+
+private:
+    char data_[Capacity];
+    Size size_{0};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_INLINE_STRING_H_
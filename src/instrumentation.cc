@@ -0,0 +1,163 @@
+#include "instrumentation.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace instrument {
+
+#if CLEAN_CONSOLE_INSTRUMENT
+
+namespace {
+
+constexpr const char* kCounterNames[kCounterCount] = {"posts", "tasks_run", "frames"};
+constexpr const char* kHistogramNames[kHistogramCount] = {"post_to_run_ns", "render_ns", "frame_bytes"};
+
+/// @brief Every shard ever handed out, shards live as long as the process
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Shard>> shards;
+    QueueGauges queue;
+};
+
+Registry& Global() {
+    // never destroyed, threads may still record during static destruction
+    static Registry* registry = new Registry;
+    return *registry;
+}
+
+Shard* Register() {
+    Registry& registry = Global();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.shards.push_back(std::make_unique<Shard>()); // value-initialized, all zero
+    return registry.shards.back().get();
+}
+
+uint64_t Percentile(const uint64_t* buckets, uint64_t count, uint64_t max, double p) {
+    auto rank = static_cast<uint64_t>(p * static_cast<double>(count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < Buckets::kCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank)
+            return std::min(Buckets::Upper(i), max);
+    }
+    return max;
+}
+
+void AppendDuration(std::string& line, uint64_t ns) {
+    auto out = std::back_inserter(line);
+    if (ns < 1000)
+        fmt::format_to(out, "{}ns", ns);
+    else if (ns < 1000000)
+        fmt::format_to(out, "{:.1f}us", ns / 1e3);
+    else if (ns < 1000000000)
+        fmt::format_to(out, "{:.2f}ms", ns / 1e6);
+    else
+        fmt::format_to(out, "{:.2f}s", ns / 1e9);
+}
+
+}  // namespace
+
+Shard& LocalShard() {
+    thread_local Shard* shard = Register();
+    return *shard;
+}
+
+QueueGauges& Queue() {
+    return Global().queue;
+}
+
+Snapshot Read() {
+    Snapshot snapshot;
+    snapshot.taken = std::chrono::steady_clock::now();
+    Registry& registry = Global();
+    snapshot.queue_depth = registry.queue.depth.load(std::memory_order_relaxed);
+    snapshot.max_queue_depth = registry.queue.max_depth.load(std::memory_order_relaxed);
+
+    uint64_t buckets[kHistogramCount][Buckets::kCount] = {};
+    uint64_t sums[kHistogramCount] = {};
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto& shard : registry.shards) {
+            for (size_t c = 0; c < kCounterCount; ++c)
+                snapshot.counters[c] += shard->counters[c].load(std::memory_order_relaxed);
+            for (size_t h = 0; h < kHistogramCount; ++h) {
+                const Shard::Hist& hist = shard->histograms[h];
+                HistogramSummary& summary = snapshot.histograms[h];
+                summary.count += hist.count.load(std::memory_order_relaxed);
+                summary.max = std::max(summary.max, hist.max.load(std::memory_order_relaxed));
+                sums[h] += hist.sum.load(std::memory_order_relaxed);
+                for (size_t i = 0; i < Buckets::kCount; ++i)
+                    buckets[h][i] += hist.buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    for (size_t h = 0; h < kHistogramCount; ++h) {
+        HistogramSummary& summary = snapshot.histograms[h];
+        if (summary.count == 0)
+            continue;
+        summary.mean = static_cast<double>(sums[h]) / static_cast<double>(summary.count);
+        summary.p50 = Percentile(buckets[h], summary.count, summary.max, 0.50);
+        summary.p90 = Percentile(buckets[h], summary.count, summary.max, 0.90);
+        summary.p99 = Percentile(buckets[h], summary.count, summary.max, 0.99);
+        summary.p999 = Percentile(buckets[h], summary.count, summary.max, 0.999);
+    }
+    return snapshot;
+}
+
+void AppendFooter(const Snapshot& now, const Snapshot& prev, std::string& line) {
+    const HistogramSummary& post = now[kPostToRunNs];
+    const HistogramSummary& render = now[kRenderNs];
+    line += "[post p50 ";
+    AppendDuration(line, post.p50);
+    line += " p99 ";
+    AppendDuration(line, post.p99);
+    line += " max ";
+    AppendDuration(line, post.max);
+    line += "] [render p50 ";
+    AppendDuration(line, render.p50);
+    line += " p99 ";
+    AppendDuration(line, render.p99);
+    fmt::format_to(std::back_inserter(line), "] [{:.0f} B/frame] [queue {}/{}] [{:.0f} tasks/s]",
+                   now[kFrameBytes].mean, now.queue_depth, now.max_queue_depth,
+                   now.PerSecond(kTasksRun, prev));
+}
+
+bool Dump(const Snapshot& snapshot, const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr)
+        return false;
+    fmt::print(file, "metric,count,mean,p50,p90,p99,p999,max\n");
+    for (size_t h = 0; h < kHistogramCount; ++h) {
+        const HistogramSummary& s = snapshot.histograms[h];
+        fmt::print(file, "{},{},{:.1f},{},{},{},{},{}\n", kHistogramNames[h], s.count, s.mean,
+                   s.p50, s.p90, s.p99, s.p999, s.max);
+    }
+    for (size_t c = 0; c < kCounterCount; ++c)
+        fmt::print(file, "{},{},,,,,,\n", kCounterNames[c], snapshot.counters[c]);
+    fmt::print(file, "queue_depth,{},,,,,,{}\n", snapshot.queue_depth, snapshot.max_queue_depth);
+    return std::fclose(file) == 0;
+}
+
+#else  // CLEAN_CONSOLE_INSTRUMENT
+
+Snapshot Read() {
+    return {};
+}
+
+void AppendFooter(const Snapshot&, const Snapshot&, std::string& line) {
+    line += "[instrumentation disabled, configure with -DCLEAN_CONSOLE_INSTRUMENT=ON]";
+}
+
+bool Dump(const Snapshot&, const std::string&) {
+    return false;
+}
+
+#endif  // CLEAN_CONSOLE_INSTRUMENT
+
+}  // namespace instrument
@@ -0,0 +1,182 @@
+#ifndef CLARKESIM_SRC_COMMON_INSTRUMENTATION_H_
+#define CLARKESIM_SRC_COMMON_INSTRUMENTATION_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// set by the CLEAN_CONSOLE_INSTRUMENT CMake option
+#ifndef CLEAN_CONSOLE_INSTRUMENT
+#define CLEAN_CONSOLE_INSTRUMENT 0
+#endif
+
+/// @brief Console latency and throughput counters
+///
+/// Every thread that records gets its own shard of plain counters and
+/// histograms, written with relaxed loads and stores (no lock, no shared
+/// cache line); Read sums the shards. With CLEAN_CONSOLE_INSTRUMENT off the
+/// recording calls are empty inlines and Read returns an empty Snapshot.
+namespace instrument {
+
+constexpr bool kEnabled = CLEAN_CONSOLE_INSTRUMENT != 0;
+
+enum Counter : uint8_t {
+    kPosts,    /* tasks posted to a console executor */
+    kTasksRun, /* tasks the executor ran */
+    kFrames,   /* frames rendered by ConsoleTablePrinter */
+    kCounterCount
+};
+
+enum Histogram : uint8_t {
+    kPostToRunNs, /* post to start of execution */
+    kRenderNs,    /* ConsoleTablePrinter::Render, formatting and write */
+    kFrameBytes,  /* bytes written per frame */
+    kHistogramCount
+};
+
+/// @brief HDR-style log-linear buckets: exact below 16, then 16 buckets
+/// per power of two (about 6% resolution), values clamp at 2^40
+struct Buckets {
+    static constexpr int kSubBits = 4;
+    static constexpr uint64_t kSub = uint64_t{1} << kSubBits;
+    static constexpr int kMaxBits = 40;
+    static constexpr size_t kCount = (kMaxBits - kSubBits + 1) * kSub;
+
+    static inline size_t Index(uint64_t v) {
+        if (v >= (uint64_t{1} << kMaxBits))
+            v = (uint64_t{1} << kMaxBits) - 1;
+        if (v < kSub)
+            return static_cast<size_t>(v);
+        int msb = 63 - __builtin_clzll(v);
+        size_t exponent = static_cast<size_t>(msb - kSubBits + 1);
+        return exponent * kSub + static_cast<size_t>((v >> (msb - kSubBits)) - kSub);
+    }
+
+    /// @brief Highest value that lands in bucket i
+    static inline uint64_t Upper(size_t i) {
+        if (i < kSub)
+            return i;
+        size_t exponent = i / kSub;
+        uint64_t mantissa = i % kSub + kSub;
+        return ((mantissa + 1) << (exponent - 1)) - 1;
+    }
+};
+
+struct HistogramSummary {
+    uint64_t count{};
+    double mean{};
+    /* bucket upper bounds, at most max */
+    uint64_t p50{};
+    uint64_t p90{};
+    uint64_t p99{};
+    uint64_t p999{};
+    uint64_t max{};
+};
+
+/// @brief Sum of every thread's shard at one point in time
+struct Snapshot {
+    std::chrono::steady_clock::time_point taken{};
+    uint64_t counters[kCounterCount]{};
+    HistogramSummary histograms[kHistogramCount]{};
+    /* executor queue depth, of the executor that posted or ran last */
+    size_t queue_depth{};
+    size_t max_queue_depth{};
+
+    inline uint64_t operator[](Counter c) const { return counters[c]; }
+    inline const HistogramSummary& operator[](Histogram h) const { return histograms[h]; }
+
+    /// @brief Rate of counter c since an earlier snapshot
+    inline double PerSecond(Counter c, const Snapshot& since) const {
+        double seconds = std::chrono::duration<double>(taken - since.taken).count();
+        return seconds > 0 ? static_cast<double>(counters[c] - since.counters[c]) / seconds : 0.0;
+    }
+};
+
+/// @brief Counters of one recording thread, only that thread writes them
+struct Shard {
+    struct Hist {
+        std::atomic<uint64_t> buckets[Buckets::kCount];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+    };
+    std::atomic<uint64_t> counters[kCounterCount];
+    Hist histograms[kHistogramCount];
+};
+
+/// @brief Shard of the calling thread, registered on first use and kept
+/// (with its counts) after the thread exits
+Shard& LocalShard();
+
+/// @brief Single writer increment, cheaper than fetch_add
+inline void Bump(std::atomic<uint64_t>& value, uint64_t n = 1) {
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline void Count(Counter c, uint64_t n = 1) {
+    if constexpr (kEnabled)
+        Bump(LocalShard().counters[c], n);
+}
+
+inline void Record(Histogram h, uint64_t value) {
+    if constexpr (kEnabled) {
+        Shard::Hist& hist = LocalShard().histograms[h];
+        Bump(hist.buckets[Buckets::Index(value)]);
+        Bump(hist.count);
+        Bump(hist.sum, value);
+        if (value > hist.max.load(std::memory_order_relaxed))
+            hist.max.store(value, std::memory_order_relaxed);
+    }
+}
+
+struct QueueGauges {
+    std::atomic<size_t> depth{0};
+    std::atomic<size_t> max_depth{0};
+};
+
+QueueGauges& Queue();
+
+/// @brief Executor queue depth gauge, written by producers and the executor
+inline void SetQueueDepth(size_t depth) {
+    if constexpr (kEnabled) {
+        QueueGauges& queue = Queue();
+        queue.depth.store(depth, std::memory_order_relaxed);
+        size_t max = queue.max_depth.load(std::memory_order_relaxed);
+        while (depth > max && !queue.max_depth.compare_exchange_weak(max, depth, std::memory_order_relaxed)) {}
+    }
+}
+
+/// @brief Elapsed time for Record, reads no clock when disabled
+class Stopwatch {
+public:
+    Stopwatch() {
+        if constexpr (kEnabled)
+            start_ = std::chrono::steady_clock::now();
+    }
+    inline uint64_t ElapsedNs() const {
+        if constexpr (kEnabled)
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_).count());
+        else
+            return 0;
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_{};
+};
+
+/// @brief Sums every shard, callable from any thread
+Snapshot Read();
+
+/// @brief Appends a one-line summary, rates are taken against prev
+void AppendFooter(const Snapshot& now, const Snapshot& prev, std::string& line);
+
+/// @brief Writes a snapshot as CSV (metric,count,mean,p50,p90,p99,p999,max)
+/// @return false when disabled or the file cannot be written
+bool Dump(const Snapshot& snapshot, const std::string& path);
+
+}  // namespace instrument
+
+#endif  // CLARKESIM_SRC_COMMON_INSTRUMENTATION_H_
@@ -0,0 +1,171 @@
+#include "output_sink.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <climits>
+#include <cerrno>
+#include <algorithm>
+
+namespace {
+
+size_t TotalBytes(const iovec* iov, size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i)
+        total += iov[i].iov_len;
+    return total;
+}
+
+}  // namespace
+
+std::shared_ptr<OutputSink> OutputSink::Terminal(int fd) {
+    // a private open file description, so O_NONBLOCK does not leak to the
+    // shell or to anything else writing to the same terminal
+    if (::isatty(fd)){
+        const char* name = ::ttyname(fd);
+        int tty = name ? ::open(name, O_WRONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC) : -1;
+        if (tty >= 0)
+            return std::make_shared<FdSink>(tty, true, true);
+    }
+    return std::make_shared<FdSink>(fd);
+}
+
+FdSink::~FdSink(){
+    if (fd_ < 0)
+        return;
+    // let the last frame finish, a stuck terminal gets a bounded wait
+    size_t syscalls = 0;
+    while (!SendPending(syscalls) && WaitWritable(kRawWaitMs)) {}
+    if (own_fd_)
+        ::close(fd_);
+}
+
+size_t FdSink::SendGathered(size_t& syscalls){
+    size_t sent = 0;
+    while (first_ < iov_.size()){
+        int count = static_cast<int>(std::min<size_t>(iov_.size() - first_, IOV_MAX));
+        ssize_t n = ::writev(fd_, &iov_[first_], count);
+        ++syscalls;
+        if (n < 0){
+            if (errno == EINTR) continue;
+            break; // EAGAIN, or a closed/broken device
+        }
+        sent += static_cast<size_t>(n);
+        auto left = static_cast<size_t>(n);
+        while (first_ < iov_.size() && left >= iov_[first_].iov_len){
+            left -= iov_[first_].iov_len;
+            ++first_;
+        }
+        if (left > 0){
+            iov_[first_].iov_base = static_cast<char*>(iov_[first_].iov_base) + left;
+            iov_[first_].iov_len -= left;
+        }
+    }
+    return sent;
+}
+
+bool FdSink::SendPending(size_t& syscalls){
+    while (pending_sent_ < pending_.size()){
+        ssize_t n = ::write(fd_, pending_.data() + pending_sent_, pending_.size() - pending_sent_);
+        ++syscalls;
+        if (n < 0){
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return false;
+            break; // the device is gone, nothing left to wait for
+        }
+        pending_sent_ += static_cast<size_t>(n);
+    }
+    pending_.clear();
+    pending_sent_ = 0;
+    return true;
+}
+
+bool FdSink::WaitWritable(int timeout_ms) const{
+    pollfd pfd{fd_, POLLOUT, 0};
+    int ready;
+    do {
+        ready = ::poll(&pfd, 1, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    return ready > 0 && (pfd.revents & POLLOUT);
+}
+
+SinkWrite FdSink::WriteFrame(const iovec* iov, size_t count){
+    SinkWrite result;
+    if (fd_ < 0 || !SendPending(result.syscalls)){
+        result.skipped = true;
+        return result;
+    }
+
+    iov_.assign(iov, iov + count);
+    first_ = 0;
+    result.bytes = SendGathered(result.syscalls);
+    if (first_ == iov_.size())
+        return result;
+    if (result.bytes == 0 && first_ == 0){
+        // not started: the next frame replaces this one instead of queueing behind it
+        result.skipped = true;
+        return result;
+    }
+
+    if (!skip_frames_){
+        // blocking fds only stop short on errors, the rest is lost
+        return result;
+    }
+    // the frame is partly on screen, its tail goes out before anything else
+    for (size_t i = first_; i < iov_.size(); ++i)
+        pending_.append(static_cast<const char*>(iov_[i].iov_base), iov_[i].iov_len);
+    return result;
+}
+
+void FdSink::WriteRaw(std::string_view bytes){
+    if (fd_ < 0)
+        return;
+    size_t syscalls = 0;
+    pending_.append(bytes.data(), bytes.size());
+    while (!SendPending(syscalls) && WaitWritable(kRawWaitMs)) {}
+}
+
+void FdSink::WriteDirect(std::string_view bytes){
+    if (fd_ >= 0)
+        (void)!::write(fd_, bytes.data(), bytes.size());
+}
+
+void FdSink::Drain(){
+    if (fd_ >= 0 && pending() > 0){
+        size_t syscalls = 0;
+        SendPending(syscalls);
+    }
+}
+
+TerminalSize FdSink::Size() const{
+    winsize size{};
+    if (fd_ < 0 || ::ioctl(fd_, TIOCGWINSZ, &size) != 0)
+        return {};
+    return {size.ws_col, size.ws_row};
+}
+
+FileSink::FileSink(const std::string& path, bool append)
+    : FdSink(::open(path.c_str(), O_WRONLY | O_CREAT | O_NOCTTY | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644),
+             true) {}
+
+SinkWrite NullSink::WriteFrame(const iovec* iov, size_t count){
+    SinkWrite result;
+    result.bytes = TotalBytes(iov, count);
+    return result;
+}
+
+SinkWrite CaptureSink::WriteFrame(const iovec* iov, size_t count){
+    SinkWrite result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < count; ++i)
+        text_.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    result.bytes = TotalBytes(iov, count);
+    ++frames_;
+    return result;
+}
+
+void CaptureSink::WriteRaw(std::string_view bytes){
+    std::lock_guard<std::mutex> lock(mutex_);
+    text_.append(bytes.data(), bytes.size());
+}
@@ -0,0 +1,165 @@
+#ifndef CLARKESIM_SRC_COMMON_OUTPUT_SINK_H_
+#define CLARKESIM_SRC_COMMON_OUTPUT_SINK_H_
+
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @brief Outcome of offering one frame to an OutputSink
+struct SinkWrite {
+    /* Bytes handed to the device by this call */
+    size_t bytes{};
+    /* write()/writev() calls issued */
+    size_t syscalls{};
+    /* Nothing of the frame was written, the screen still shows the last one */
+    bool skipped{false};
+};
+
+/// @brief Character cells of a terminal, 0 when unknown (not a tty)
+struct TerminalSize {
+    size_t columns{};
+    size_t rows{};
+};
+
+/// @brief Destination of everything the console draws
+///
+/// A frame is written whole or not at all: a sink that cannot take it
+/// without blocking reports it skipped and the caller diffs its next frame
+/// against the last one that was accepted.
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+
+    /// @brief Writes one frame given as a gather list
+    virtual SinkWrite WriteFrame(const iovec* iov, size_t count) = 0;
+
+    /// @brief Writes bytes outside of any frame (banner, terminal restore),
+    /// waiting a bounded time for room rather than skipping them
+    virtual void WriteRaw(std::string_view bytes) = 0;
+
+    /// @brief Best effort write of bytes that must reach the device even
+    /// while another thread is blocked inside WriteFrame (signal and crash
+    /// paths): one attempt, no sink state is touched, may interleave
+    virtual void WriteDirect(std::string_view bytes) { (void)bytes; }
+
+    /// @brief Retries output an earlier frame left pending, called every frame
+    virtual void Drain() {}
+
+    /// @brief Current size of the terminal behind the sink, queried on every
+    /// call so it follows resizes
+    virtual TerminalSize Size() const { return {}; }
+
+    /// @brief Sink for a terminal on fd: a tty is reopened non-blocking and
+    /// skips frames while it is full, anything else is written blocking
+    static std::shared_ptr<OutputSink> Terminal(int fd = STDOUT_FILENO);
+};
+
+/// @brief writev() to a file descriptor (tty, PTY, pipe or file)
+///
+/// In skip-frames mode the fd must be non-blocking: a frame the device
+/// takes none of is skipped, so the next frame replaces it; a frame it
+/// takes only part of keeps its tail in a pending buffer, sent before
+/// anything else, and frames offered while a tail is pending are skipped.
+/// Frames are therefore never interleaved or cut, only dropped whole.
+class FdSink : public OutputSink {
+public:
+    /// @param own_fd close fd on destruction
+    /// @param skip_frames fd is non-blocking, skip frames instead of waiting
+    explicit FdSink(int fd, bool own_fd = false, bool skip_frames = false)
+        : fd_(fd), own_fd_(own_fd), skip_frames_(skip_frames) {}
+    ~FdSink() override;
+
+    FdSink(const FdSink&) = delete;
+    FdSink& operator=(const FdSink&) = delete;
+
+    SinkWrite WriteFrame(const iovec* iov, size_t count) override;
+    void WriteRaw(std::string_view bytes) override;
+    void WriteDirect(std::string_view bytes) override;
+    void Drain() override;
+    TerminalSize Size() const override;
+
+    inline int fd() const { return fd_; }
+    inline bool ok() const { return fd_ >= 0; }
+    /// @brief Bytes of an accepted frame still waiting for the device
+    inline size_t pending() const { return pending_.size() - pending_sent_; }
+
+private:
+    /// @brief Sends iov_ until done, EAGAIN or an error, returns the bytes sent
+    /// iov_[first_..] is what is left afterwards
+    size_t SendGathered(size_t& syscalls);
+    /// @brief Sends the pending tail, true once it is empty
+    bool SendPending(size_t& syscalls);
+    /// @brief Waits up to timeout_ms for the fd to take more bytes
+    bool WaitWritable(int timeout_ms) const;
+
+    static constexpr int kRawWaitMs = 500;
+
+    int fd_;
+    bool own_fd_;
+    bool skip_frames_;
+    /* Gather list being sent, adjusted in place by partial writes */
+    std::vector<iovec> iov_{};
+    size_t first_{0};
+    /* Unsent tail of the last accepted frame */
+    std::string pending_{};
+    size_t pending_sent_{0};
+};
+
+/// @brief FdSink on a path it opens: a log file, or a tty/PTY such as /dev/pts/3
+class FileSink : public FdSink {
+public:
+    explicit FileSink(const std::string& path, bool append = false);
+};
+
+/// @brief Discards every frame but reports it written, for benchmarks
+class NullSink : public OutputSink {
+public:
+    SinkWrite WriteFrame(const iovec* iov, size_t count) override;
+    void WriteRaw(std::string_view) override {}
+};
+
+/// @brief Keeps everything written in memory, for tests
+class CaptureSink : public OutputSink {
+public:
+    SinkWrite WriteFrame(const iovec* iov, size_t count) override;
+    void WriteRaw(std::string_view bytes) override;
+    inline void WriteDirect(std::string_view bytes) override { WriteRaw(bytes); }
+
+    /// @brief Reported by Size(), e.g. to play a resize to the console
+    inline void setSize(TerminalSize size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_ = size;
+    }
+    inline TerminalSize Size() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+    /// @brief Everything captured so far, frames and raw bytes in order
+    inline std::string text() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return text_;
+    }
+    inline size_t frames() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return frames_;
+    }
+    inline void Clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        text_.clear();
+        frames_ = 0;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::string text_{};
+    size_t frames_{0};
+    TerminalSize size_{};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_OUTPUT_SINK_H_
@@ -0,0 +1,55 @@
+#ifndef CLARKESIM_SRC_COMMON_SCHEMA_REGISTRY_H_
+#define CLARKESIM_SRC_COMMON_SCHEMA_REGISTRY_H_
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include "console_base.h"
+#include "thread_manager.h"
+
+/// @brief Thread-safe store of telemetry column layouts
+///
+/// Producers register a layout once and stamp the returned handle into
+/// every TelemetrySample. Entries are never removed, so references handed
+/// out by Get stay valid for the lifetime of the registry.
+class SchemaRegistry : private ThreadSafe {
+public:
+    inline SchemaHandle Register(std::vector<Column> columns, int precision, const StaticLayout& layout = {}) {
+        auto lock = WriteLock();
+        schemas_.push_back({std::move(columns), precision, layout});
+        return static_cast<SchemaHandle>(schemas_.size() - 1);
+    }
+
+    /// @brief Returns the handle of an equal runtime layout, registering it if new
+    /// Static layouts are never shared, their widths are their own
+    inline SchemaHandle Intern(const std::vector<Column>& columns, int precision = 2) {
+        {
+            auto lock = ReadLock();
+            auto it = std::find_if(schemas_.begin(), schemas_.end(),
+                [&](const TelemetrySchema& s){ return !s.layout.format && s.precision == precision && SameColumns(s.columns, columns); });
+            if (it != schemas_.end())
+                return static_cast<SchemaHandle>(it - schemas_.begin());
+        }
+        return Register(columns, precision);
+    }
+
+    inline const TelemetrySchema& Get(SchemaHandle handle) const {
+        auto lock = ReadLock();
+        return schemas_.at(handle);
+    }
+
+    inline size_t size() const {
+        auto lock = ReadLock();
+        return schemas_.size();
+    }
+
+    static bool SameColumns(const std::vector<Column>& a, const std::vector<Column>& b){
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+            [](const Column& x, const Column& y){ return x.align == y.align && x.aggregate == y.aggregate && x.title == y.title; });
+    }
+
+private:
+    std::deque<TelemetrySchema> schemas_{};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_SCHEMA_REGISTRY_H_
@@ -0,0 +1,317 @@
+#include "shm_console.h"
+
+#include <algorithm>
+#include <cstring>
+#include "console.h"
+
+using namespace shm_ring;
+
+namespace {
+
+/// @brief Appends bytes to a payload being encoded, false once it is full
+struct Encoder {
+    unsigned char* out;
+    size_t size{0};
+
+    inline bool Put(const void* data, size_t len) {
+        if (size + len > kMaxPayload)
+            return false;
+        std::memcpy(out + size, data, len);
+        size += len;
+        return true;
+    }
+};
+
+/// @brief Length-prefixed text, cut to what still fits
+inline void PutText(Encoder& enc, std::string_view text) {
+    size_t room = kMaxPayload - std::min(enc.size + sizeof(uint16_t), kMaxPayload);
+    auto len = static_cast<uint16_t>(std::min(text.size(), room));
+    if (enc.Put(&len, sizeof(len)))
+        enc.Put(text.data(), len);
+}
+
+}  // namespace
+
+ShmConsole::ShmConsole(const std::string& name, uint32_t slots){
+    if (ring_.Create(name, slots))
+        seen_epoch_ = ring_.attach_epoch();
+}
+
+void ShmConsole::CheckAttach(){
+    if (!ok())
+        return;
+    uint64_t epoch = ring_.attach_epoch();
+    if (epoch == seen_epoch_)
+        return;
+    seen_epoch_ = epoch;
+    for (SchemaHandle handle = 0; handle < schemas_.size(); ++handle)
+        PublishSchema(handle);
+    for (TableId table = 1; table < tables_.size(); ++table)
+        PublishTable(table);
+    for (const IStatusPrint& status : statuses_.History(kSnapshotStatuses))
+        PublishStatus(polling_.count(status.id) ? flight_log::kStatusPollStart : flight_log::kStatusNew,
+                      status);
+}
+
+void ShmConsole::PublishSchema(SchemaHandle handle){
+    const TelemetrySchema& schema = schemas_.Get(handle);
+    Encoder enc{buffer_};
+    SchemaMessage msg{handle, schema.precision, 0};
+    enc.Put(&msg, sizeof(msg));
+    for (const Column& col : schema.columns){
+        uint8_t format[2] = {static_cast<uint8_t>(col.align), static_cast<uint8_t>(col.aggregate)};
+        if (enc.size + sizeof(format) + sizeof(uint16_t) + col.title.size() > kMaxPayload ||
+            msg.columns == kMaxTelemetryColumns)
+            break;
+        enc.Put(format, sizeof(format));
+        PutText(enc, col.title);
+        ++msg.columns;
+    }
+    std::memcpy(buffer_, &msg, sizeof(msg));
+    ring_.Publish(kSchemaMessage, buffer_, enc.size);
+}
+
+void ShmConsole::PublishTable(TableId table){
+    const TableOptions& options = tables_[table];
+    Encoder enc{buffer_};
+    TableMessage msg{table, 0, options.max_rows, options.window_samples,
+                     options.refresh_hz, options.window_s};
+    msg.name_len = static_cast<uint32_t>(std::min(options.name.size(), kMaxPayload - sizeof(msg)));
+    enc.Put(&msg, sizeof(msg));
+    enc.Put(options.name.data(), msg.name_len);
+    ring_.Publish(kTableMessage, buffer_, enc.size);
+}
+
+void ShmConsole::PublishStatus(flight_log::StatusEvent event, const IStatusPrint& status){
+    std::string_view header = status.header.view();
+    StatusMessage msg{status.id, event, static_cast<uint16_t>(status.level),
+                      static_cast<uint16_t>(std::min<size_t>(header.size(), 255)),
+                      static_cast<uint16_t>(status.data.size())};
+    Encoder enc{buffer_};
+    enc.Put(&msg, sizeof(msg));
+    enc.Put(header.data(), msg.header_len);
+    enc.Put(status.data.data(), msg.data_len);
+    ring_.Publish(kStatusMessage, buffer_, enc.size);
+}
+
+size_t ShmConsole::AppendStatus(const IStatusPrint& status, flight_log::StatusEvent event){
+    CheckAttach();
+    size_t id = statuses_.Push(status);
+    if (ok()){
+        IStatusPrint published = status;
+        published.id = id;
+        PublishStatus(event, published);
+    }
+    return id;
+}
+
+size_t ShmConsole::newStatus(const IStatusPrint& status){
+    return AppendStatus(status, flight_log::kStatusNew);
+}
+
+size_t ShmConsole::startPolling(const IStatusPrint& status){
+    size_t id = AppendStatus(status, flight_log::kStatusPollStart);
+    polling_.insert(id);
+    return id;
+}
+
+void ShmConsole::stopPolling(size_t id, const IStatusPrint& status){
+    CheckAttach();
+    if (polling_.erase(id) == 0)
+        return;
+    IStatusPrint published = status;
+    published.id = id;
+    if (IStatusPrint* row = statuses_.Find(id))
+        *row = published;
+    if (ok())
+        PublishStatus(flight_log::kStatusPollStop, published);
+}
+
+SchemaHandle ShmConsole::registerSchema(std::vector<Column> columns, int precision){
+    CheckAttach();
+    SchemaHandle handle = schemas_.Register(std::move(columns), precision);
+    if (ok())
+        PublishSchema(handle);
+    return handle;
+}
+
+TableId ShmConsole::addTable(const TableOptions& options){
+    CheckAttach();
+    tables_.push_back(options);
+    auto table = static_cast<TableId>(tables_.size() - 1);
+    if (ok())
+        PublishTable(table);
+    return table;
+}
+
+bool ShmConsole::addSample(const TelemetrySample& sample){
+    CheckAttach();
+    if (ok())
+        ring_.Publish(kSampleMessage, &sample, sizeof(sample));
+    return false;
+}
+
+bool ShmConsole::addTelemetry(const ITelemetryPrint telem){
+    CheckAttach();
+    size_t known = schemas_.size();
+    SchemaHandle schema = schemas_.Intern(telem.columns);
+    if (!ok())
+        return false;
+    if (schema >= known)
+        PublishSchema(schema);
+
+    Encoder enc{buffer_};
+    TextRowMessage msg{schema, telem.table, 0};
+    enc.Put(&msg, sizeof(msg));
+    for (const std::string& cell : telem.data){
+        if (enc.size + sizeof(uint16_t) + cell.size() > kMaxPayload || msg.cells == kMaxTelemetryColumns)
+            break;
+        PutText(enc, cell);
+        ++msg.cells;
+    }
+    std::memcpy(buffer_, &msg, sizeof(msg));
+    ring_.Publish(kTextRowMessage, buffer_, enc.size);
+    return false;
+}
+
+bool ShmConsole::advanceAnimations(std::chrono::steady_clock::time_point){
+    CheckAttach();
+    return false;
+}
+
+void ShmConsole::printTelemTable(bool){
+    CheckAttach();
+}
+
+std::vector<std::string> ShmConsole::convert_data(const std::vector<double>& data){
+    return convert_to_strings(data);
+}
+
+size_t ShmViewer::Poll(IConsole& console, size_t max){
+    size_t applied = 0;
+    uint16_t type;
+    size_t size;
+    while (applied < max && ring_.Read(type, buffer_, size)){
+        Apply(console, type, buffer_, size);
+        ++applied;
+    }
+    return applied;
+}
+
+void ShmViewer::Apply(IConsole& console, uint16_t type, const unsigned char* payload, size_t size){
+    auto text = [&](size_t& offset, size_t len){
+        len = std::min(len, size - std::min(offset, size));
+        std::string_view view(reinterpret_cast<const char*>(payload + offset), len);
+        offset += len;
+        return view;
+    };
+    auto length = [&](size_t& offset){
+        uint16_t len = 0;
+        if (offset + sizeof(len) <= size)
+            std::memcpy(&len, payload + offset, sizeof(len));
+        offset += sizeof(len);
+        return len;
+    };
+
+    switch (type){
+        case kSchemaMessage: {
+            SchemaMessage msg;
+            if (size < sizeof(msg)) return;
+            std::memcpy(&msg, payload, sizeof(msg));
+            if (schemas_.count(msg.schema)) return; // snapshot of a known schema
+            std::vector<Column> columns;
+            size_t offset = sizeof(msg);
+            for (uint32_t c = 0; c < msg.columns && offset + 2 <= size; ++c){
+                auto align = static_cast<ColumnAlign>(payload[offset]);
+                auto aggregate = static_cast<Aggregate>(payload[offset + 1]);
+                offset += 2;
+                size_t len = length(offset);
+                columns.push_back({std::string(text(offset, len)), align, aggregate});
+            }
+            schemas_[msg.schema] = console.registerSchema(columns, msg.precision);
+            schema_columns_[msg.schema] = std::move(columns);
+            break;
+        }
+        case kTableMessage: {
+            TableMessage msg;
+            if (size < sizeof(msg)) return;
+            std::memcpy(&msg, payload, sizeof(msg));
+            if (tables_.count(msg.table)) return;
+            size_t offset = sizeof(msg);
+            TableOptions options;
+            options.name = std::string(text(offset, msg.name_len));
+            options.max_rows = msg.max_rows;
+            options.refresh_hz = msg.refresh_hz;
+            options.window_samples = msg.window_samples;
+            options.window_s = msg.window_s;
+            tables_[msg.table] = console.addTable(options);
+            break;
+        }
+        case kSampleMessage: {
+            TelemetrySample sample;
+            if (size < sizeof(sample)) return;
+            std::memcpy(&sample, payload, sizeof(sample));
+            auto schema = schemas_.find(sample.schema);
+            auto table = tables_.find(sample.table);
+            // the count indexes the values array downstream, a corrupt one is dropped
+            if (sample.count > kMaxTelemetryColumns
+                || schema == schemas_.end() || table == tables_.end()){
+                ++orphans_;
+                return;
+            }
+            sample.schema = schema->second;
+            sample.table = table->second;
+            console.addSample(sample);
+            break;
+        }
+        case kTextRowMessage: {
+            TextRowMessage msg;
+            if (size < sizeof(msg)) return;
+            std::memcpy(&msg, payload, sizeof(msg));
+            auto columns = schema_columns_.find(msg.schema);
+            auto table = tables_.find(msg.table);
+            if (columns == schema_columns_.end() || table == tables_.end()){
+                ++orphans_;
+                return;
+            }
+            ITelemetryPrint row{columns->second, {}, table->second};
+            size_t offset = sizeof(msg);
+            for (uint32_t c = 0; c < msg.cells && offset < size; ++c){
+                size_t len = length(offset);
+                row.data.emplace_back(text(offset, len));
+            }
+            console.addTelemetry(std::move(row));
+            break;
+        }
+        case kStatusMessage: {
+            StatusMessage msg;
+            if (size < sizeof(msg)) return;
+            std::memcpy(&msg, payload, sizeof(msg));
+            size_t offset = sizeof(msg);
+            std::string_view header = text(offset, msg.header_len);
+            std::string_view data = text(offset, msg.data_len);
+            IStatusPrint status{static_cast<ConsoleLevels>(msg.level), header, data};
+
+            if (msg.event == flight_log::kStatusPollStop){
+                auto polled = polling_.find(msg.id);
+                if (polled != polling_.end()){
+                    console.stopPolling(polled->second, status);
+                    polling_.erase(polled);
+                }
+                break;
+            }
+            // ids only grow, an older one is a snapshot sent for another viewer
+            if (seen_status_ && msg.id <= newest_status_)
+                break;
+            seen_status_ = true;
+            newest_status_ = msg.id;
+            if (msg.event == flight_log::kStatusPollStart)
+                polling_[msg.id] = console.startPolling(status);
+            else
+                console.newStatus(status);
+            break;
+        }
+        default:
+            break;
+    }
+}
@@ -0,0 +1,143 @@
+#ifndef CLARKESIM_SRC_COMMON_SHM_CONSOLE_H_
+#define CLARKESIM_SRC_COMMON_SHM_CONSOLE_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "console_base.h"
+#include "flight_recorder.h"
+#include "schema_registry.h"
+#include "shm_ring.h"
+#include "status_region.h"
+
+/// @brief Messages carried by the ring between ShmConsole and ShmViewer
+namespace shm_ring {
+
+enum MessageType : uint16_t {
+    kSchemaMessage = 1,  /* SchemaMessage + columns like flight_log::SchemaRecord */
+    kTableMessage = 2,   /* TableMessage + name */
+    kSampleMessage = 3,  /* TelemetrySample */
+    kTextRowMessage = 4, /* TextRowMessage + cells x {uint16 len, text} */
+    kStatusMessage = 5   /* StatusMessage + header + data */
+};
+
+struct SchemaMessage {
+    uint32_t schema;
+    int32_t precision;
+    uint32_t columns;
+};
+
+struct TableMessage {
+    uint32_t table;
+    uint32_t name_len;
+    uint64_t max_rows;
+    uint64_t window_samples;
+    double refresh_hz;
+    double window_s;
+};
+
+struct TextRowMessage {
+    uint32_t schema;
+    uint32_t table;
+    uint32_t cells;
+};
+
+struct StatusMessage {
+    uint64_t id;
+    uint16_t event; /* flight_log::StatusEvent */
+    uint16_t level;
+    uint16_t header_len;
+    uint16_t data_len;
+};
+
+}  // namespace shm_ring
+
+/// @brief IConsole that serializes every call into a shared-memory ring
+/// instead of drawing, for a clean_console_view process to render
+///
+/// Every call is a copy into the next ring slot and never waits: a slow or
+/// paused viewer loses messages (counted in viewerDrops) instead of
+/// stalling the executor. When a viewer attaches it asks for a snapshot
+/// and the next call republishes the schemas, tables and recent statuses,
+/// so viewers can come and go while the sim runs. Not thread-safe, post to
+/// it through ThreadManager like any other console.
+class ShmConsole : public IConsole {
+public:
+    /// @param name POSIX shm name, e.g. "clean_console"
+    explicit ShmConsole(const std::string& name, uint32_t slots = 4096);
+
+    inline bool ok() const { return ring_.ok(); }
+    inline uint64_t published() const { return ring_.published(); }
+    inline uint64_t viewerDrops() const { return ring_.viewer_drops(); }
+
+    //****************************************************//
+    size_t newStatus(const IStatusPrint& status) override;
+    bool addTelemetry(const ITelemetryPrint telem) override;
+    SchemaHandle registerSchema(std::vector<Column> columns, int precision) override;
+    TableId addTable(const TableOptions& options) override;
+    bool addSample(const TelemetrySample& sample) override;
+    size_t startPolling(const IStatusPrint& status) override;
+    void stopPolling(size_t id, const IStatusPrint& status) override;
+    /// @brief Viewers animate on their own, only answers attach requests
+    bool advanceAnimations(std::chrono::steady_clock::time_point now) override;
+    /// @brief Viewers redraw at their own rate, only answers attach requests
+    void printTelemTable(bool full_redraw) override;
+    std::vector<std::string> convert_data(const std::vector<double>& data) override;
+    //****************************************************//
+
+private:
+    /// @brief Republishes the current state when a viewer attached since the last call
+    void CheckAttach();
+    void PublishSchema(SchemaHandle handle);
+    void PublishTable(TableId table);
+    void PublishStatus(flight_log::StatusEvent event, const IStatusPrint& status);
+    size_t AppendStatus(const IStatusPrint& status, flight_log::StatusEvent event);
+
+    ShmRing ring_{};
+    uint64_t seen_epoch_{0};
+    SchemaRegistry schemas_{};
+    std::vector<TableOptions> tables_{TableOptions{}};
+    /* the newest statuses, replayed to viewers that attach late */
+    static constexpr size_t kSnapshotStatuses = 64;
+    StatusRegion statuses_{kSnapshotStatuses, kSnapshotStatuses};
+    std::unordered_set<size_t> polling_{};
+    /* message being encoded, one slot payload */
+    unsigned char buffer_[shm_ring::kMaxPayload];
+};
+
+/// @brief Applies the messages of an attached ShmRing to a local IConsole
+///
+/// Publisher schema, table and status ids are mapped to the ids of the
+/// local console, the way FlightReplay maps a recorded log. Snapshot
+/// messages for things this viewer already knows are skipped.
+/// Only polling status ids are mapped, so memory stays flat.
+class ShmViewer {
+public:
+    explicit ShmViewer(ShmRing& ring) : ring_(ring) {}
+
+    /// @brief Applies up to max pending messages
+    /// @return messages applied, 0 once the viewer has caught up
+    size_t Poll(IConsole& console, size_t max);
+
+    /// @brief Rows dropped because their schema or table was never received
+    /// or their column count was out of range
+    inline uint64_t orphans() const { return orphans_; }
+
+private:
+    void Apply(IConsole& console, uint16_t type, const unsigned char* payload, size_t size);
+
+    ShmRing& ring_;
+    std::unordered_map<uint32_t, SchemaHandle> schemas_{};
+    std::unordered_map<uint32_t, std::vector<Column>> schema_columns_{};
+    std::unordered_map<uint32_t, TableId> tables_{{kDefaultTable, kDefaultTable}};
+    /* publisher id -> local id of statuses still polling */
+    std::unordered_map<uint64_t, size_t> polling_{};
+    uint64_t newest_status_{0};
+    bool seen_status_{false};
+    uint64_t orphans_{0};
+    unsigned char buffer_[shm_ring::kMaxPayload];
+};
+
+#endif  // CLARKESIM_SRC_COMMON_SHM_CONSOLE_H_
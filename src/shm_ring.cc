@@ -0,0 +1,149 @@
+#include "shm_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+using namespace shm_ring;
+
+namespace {
+
+std::string ShmPath(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+size_t RingBytes(uint32_t slots) {
+    return sizeof(Header) + static_cast<size_t>(slots) * sizeof(Slot);
+}
+
+}  // namespace
+
+ShmRing::~ShmRing(){
+    if (header_ != nullptr)
+        ::munmap(header_, bytes_);
+    if (!unlink_name_.empty())
+        ::shm_unlink(unlink_name_.c_str());
+}
+
+bool ShmRing::Map(int fd, size_t bytes){
+    void* map = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+        return false;
+    header_ = static_cast<Header*>(map);
+    slots_ = reinterpret_cast<Slot*>(static_cast<unsigned char*>(map) + sizeof(Header));
+    bytes_ = bytes;
+    return true;
+}
+
+bool ShmRing::Create(const std::string& name, uint32_t slots){
+    if (slots == 0)
+        return false;
+    std::string path = ShmPath(name);
+    int fd = ::shm_open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+        return false;
+    size_t bytes = RingBytes(slots);
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0){
+        ::close(fd);
+        return false;
+    }
+    if (!Map(fd, bytes)) // closes fd
+        return false;
+
+    // a restarted publisher starts a fresh ring, the magic goes last so
+    // a viewer never sees a half initialized header
+    std::memset(header_->magic, 0, sizeof(header_->magic));
+    new (&header_->head) std::atomic<uint64_t>(0);
+    new (&header_->attach_epoch) std::atomic<uint64_t>(0);
+    new (&header_->viewer_drops) std::atomic<uint64_t>(0);
+    for (uint32_t i = 0; i < slots; ++i)
+        new (&slots_[i].seq) std::atomic<uint64_t>(0);
+    header_->version = kVersion;
+    header_->slots = slots;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header_->magic, kMagic, sizeof(kMagic));
+    unlink_name_ = path;
+    return true;
+}
+
+bool ShmRing::Attach(const std::string& name){
+    int fd = ::shm_open(ShmPath(name).c_str(), O_RDWR, 0);
+    if (fd < 0)
+        return false;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)){
+        ::close(fd);
+        return false;
+    }
+    if (!Map(fd, static_cast<size_t>(st.st_size))) // closes fd
+        return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0 || header_->version != kVersion ||
+        RingBytes(header_->slots) > bytes_){
+        ::munmap(header_, bytes_);
+        header_ = nullptr;
+        return false;
+    }
+    next_ = header_->head.load(std::memory_order_acquire);
+    // the publisher answers with a snapshot of schemas, tables and statuses
+    header_->attach_epoch.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+bool ShmRing::Publish(uint16_t type, const void* payload, size_t size){
+    if (size > kMaxPayload)
+        return false;
+    uint64_t n = header_->head.load(std::memory_order_relaxed);
+    Slot& slot = slots_[n % header_->slots];
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.type = type;
+    slot.size = static_cast<uint16_t>(size);
+    std::memcpy(slot.payload, payload, size);
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+    header_->head.store(n + 1, std::memory_order_release);
+    return true;
+}
+
+void ShmRing::Drop(uint64_t count){
+    drops_ += count;
+    header_->viewer_drops.fetch_add(count, std::memory_order_relaxed);
+}
+
+bool ShmRing::Read(uint16_t& type, unsigned char* payload, size_t& size){
+    for (;;){
+        uint64_t head = header_->head.load(std::memory_order_acquire);
+        if (next_ >= head){
+            next_ = head; // the publisher restarted the ring
+            return false;
+        }
+        // lapped: everything older than one ring behind head is gone
+        uint64_t slots = header_->slots;
+        if (head - next_ > slots){
+            Drop(head - next_ - slots);
+            next_ = head - slots;
+        }
+
+        const Slot& slot = slots_[next_ % slots];
+        uint64_t expected = 2 * next_ + 2;
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        if (before == expected){
+            type = slot.type;
+            size = std::min<size_t>(slot.size, kMaxPayload);
+            std::memcpy(payload, slot.payload, size);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == expected){
+                ++next_;
+                return true;
+            }
+        }
+        // overwritten while we looked at it, skip it and retry
+        Drop(1);
+        ++next_;
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef CLARKESIM_SRC_COMMON_SHM_RING_H_
+#define CLARKESIM_SRC_COMMON_SHM_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// @brief Layout of the shared-memory broadcast ring (native endianness)
+///
+/// One publisher writes fixed-size slots round-robin and never waits for
+/// readers: a reader that falls a full lap behind finds its slots
+/// overwritten and skips ahead, counting what it lost. Each slot carries a
+/// sequence number, odd while it is being written and 2 * (n + 1) once
+/// message n is complete, so a reader detects torn or overwritten slots
+/// without any lock.
+namespace shm_ring {
+
+constexpr char kMagic[8] = {'C', 'C', 'S', 'H', 'R', 'I', 'N', 'G'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kSlotBytes = 1024;
+
+struct Slot {
+    std::atomic<uint64_t> seq;
+    uint16_t type;
+    uint16_t size;
+    uint32_t reserved;
+    unsigned char payload[kSlotBytes - 16];
+};
+constexpr size_t kMaxPayload = sizeof(Slot::payload);
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t slots;
+    /* messages published, the newest is head - 1 */
+    alignas(64) std::atomic<uint64_t> head;
+    /* bumped by each viewer that attaches, asks for a state snapshot */
+    alignas(64) std::atomic<uint64_t> attach_epoch;
+    /* messages lost by all viewers together, for the publisher's stats */
+    std::atomic<uint64_t> viewer_drops;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must be lock free");
+static_assert(sizeof(Slot) == kSlotBytes, "unexpected slot padding");
+
+}  // namespace shm_ring
+
+/// @brief POSIX shared-memory ring: Create on the publishing side, Attach
+/// on each viewer. Viewers can attach and detach at any time.
+class ShmRing {
+public:
+    ShmRing() = default;
+    ~ShmRing();
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    /// @brief Creates (or takes over) /name with `slots` slots, the name is
+    /// unlinked again when this ring is destroyed
+    /// @return false when the segment cannot be created or mapped
+    bool Create(const std::string& name, uint32_t slots = 4096);
+
+    /// @brief Maps an existing ring as a reader, starting at its newest message
+    /// @return false when no compatible ring exists under name
+    bool Attach(const std::string& name);
+
+    inline bool ok() const { return header_ != nullptr; }
+
+    //************ publisher ************//
+    /// @brief Copies one message into the next slot, never blocks
+    /// @return false when size exceeds shm_ring::kMaxPayload
+    bool Publish(uint16_t type, const void* payload, size_t size);
+
+    inline uint64_t published() const { return header_->head.load(std::memory_order_relaxed); }
+    inline uint64_t attach_epoch() const { return header_->attach_epoch.load(std::memory_order_relaxed); }
+    inline uint64_t viewer_drops() const { return header_->viewer_drops.load(std::memory_order_relaxed); }
+
+    //************ viewer ************//
+    /// @brief Copies the next message into payload (kMaxPayload bytes)
+    /// @return false when the reader has caught up with the publisher
+    bool Read(uint16_t& type, unsigned char* payload, size_t& size);
+
+    /// @brief Messages this reader lost by being lapped
+    inline uint64_t drops() const { return drops_; }
+
+private:
+    bool Map(int fd, size_t bytes);
+    void Drop(uint64_t count);
+
+    shm_ring::Header* header_{nullptr};
+    shm_ring::Slot* slots_{nullptr};
+    size_t bytes_{0};
+    std::string unlink_name_{};
+    /* reader cursor: index of the next message to read */
+    uint64_t next_{0};
+    uint64_t drops_{0};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_SHM_RING_H_
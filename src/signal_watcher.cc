@@ -0,0 +1,102 @@
+#include "signal_watcher.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+
+namespace {
+
+/* Write end of the watching pipe + 1 for each signal, 0 when unwatched */
+std::atomic<int> g_pipes[NSIG];
+static_assert(std::atomic<int>::is_always_lock_free, "the signal handler needs a lock free atomic");
+
+/* Wakes the watcher thread to exit, never a signal number */
+constexpr unsigned char kStopByte = 0;
+
+}  // namespace
+
+void SignalWatcher::OnSignal(int signo){
+    int saved_errno = errno;
+    int fd = g_pipes[signo].load(std::memory_order_relaxed) - 1;
+    if (fd >= 0){
+        // a full pipe already holds a wakeup, the byte can be lost
+        auto byte = static_cast<unsigned char>(signo);
+        (void)!::write(fd, &byte, 1);
+    }
+    errno = saved_errno;
+}
+
+SignalWatcher::SignalWatcher(std::vector<int> signals, Callback callback)
+    : callback_(std::move(callback)){
+    if (::pipe2(pipe_, O_NONBLOCK | O_CLOEXEC) != 0){
+        pipe_[0] = pipe_[1] = -1;
+        return;
+    }
+    for (int signo : signals){
+        if (signo <= 0 || signo >= NSIG)
+            continue;
+        int unwatched = 0;
+        if (!g_pipes[signo].compare_exchange_strong(unwatched, pipe_[1] + 1))
+            continue; // another watcher has it
+        struct sigaction action{};
+        action.sa_handler = &SignalWatcher::OnSignal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        struct sigaction previous{};
+        if (::sigaction(signo, &action, &previous) != 0){
+            g_pipes[signo].store(0);
+            continue;
+        }
+        signals_.push_back(signo);
+        previous_.push_back(previous);
+    }
+    if (!signals_.empty())
+        thread_ = std::thread([this] { Run(); });
+}
+
+SignalWatcher::~SignalWatcher(){
+    for (size_t i = 0; i < signals_.size(); ++i){
+        ::sigaction(signals_[i], &previous_[i], nullptr);
+        g_pipes[signals_[i]].store(0);
+    }
+    if (thread_.joinable()){
+        while (::write(pipe_[1], &kStopByte, 1) < 0 && (errno == EAGAIN || errno == EINTR))
+            std::this_thread::yield();
+        thread_.join();
+    }
+    if (pipe_[0] >= 0){
+        ::close(pipe_[0]);
+        ::close(pipe_[1]);
+    }
+}
+
+void SignalWatcher::Run(){
+    for (;;){
+        pollfd pfd{pipe_[0], POLLIN, 0};
+        if (::poll(&pfd, 1, -1) < 0){
+            if (errno == EINTR) continue;
+            return;
+        }
+        // everything queued so far is one wakeup, a burst of SIGWINCH
+        // while a window is dragged is reported once
+        bool seen[NSIG] = {};
+        bool stop = false;
+        unsigned char bytes[64];
+        ssize_t n;
+        while ((n = ::read(pipe_[0], bytes, sizeof(bytes))) > 0 || (n < 0 && errno == EINTR)){
+            for (ssize_t i = 0; i < n; ++i){
+                if (bytes[i] == kStopByte)
+                    stop = true;
+                else if (bytes[i] < NSIG)
+                    seen[bytes[i]] = true;
+            }
+        }
+        for (int signo : signals_)
+            if (seen[signo])
+                callback_(signo);
+        if (stop)
+            return;
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef CLARKESIM_SRC_COMMON_SIGNAL_WATCHER_H_
+#define CLARKESIM_SRC_COMMON_SIGNAL_WATCHER_H_
+
+#include <csignal>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/// @brief Delivers signals to a normal thread through a self-pipe
+///
+/// The installed handler only write()s the signal number into a pipe,
+/// which is async-signal-safe; a watcher thread blocked in poll() reads it
+/// and calls the callback, where anything goes (locks, allocation, posting
+/// to the console executor). Signals arriving while the callback runs are
+/// merged: each signal is reported once per wakeup.
+///
+/// A signal is watched by one SignalWatcher at a time, the previous
+/// disposition is restored on destruction.
+class SignalWatcher {
+public:
+    using Callback = std::function<void(int signo)>;
+
+    SignalWatcher(std::vector<int> signals, Callback callback);
+    ~SignalWatcher();
+
+    SignalWatcher(const SignalWatcher&) = delete;
+    SignalWatcher& operator=(const SignalWatcher&) = delete;
+
+    /// @brief Signals this watcher installed its handler for
+    inline const std::vector<int>& signals() const { return signals_; }
+
+private:
+    static void OnSignal(int signo);
+    void Run();
+
+    std::vector<int> signals_{};
+    std::vector<struct sigaction> previous_{};
+    Callback callback_;
+    /* [0] read by the watcher thread, [1] written by the handler */
+    int pipe_[2]{-1, -1};
+    std::thread thread_{};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_SIGNAL_WATCHER_H_
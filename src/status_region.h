@@ -0,0 +1,72 @@
+#ifndef CLARKESIM_SRC_COMMON_STATUS_REGION_H_
+#define CLARKESIM_SRC_COMMON_STATUS_REGION_H_
+
+#include <boost/circular_buffer.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "console_base.h"
+
+/// @brief Fixed-capacity status lines: the newest `visible` are drawn, the
+/// newest `history` can be queried, older ones are dropped
+///
+/// Ids are handed out in push order and never reused, so the ring always
+/// holds a contiguous id range and id -> slot is a subtraction. Memory and
+/// the drawn height stay flat no matter how many statuses a run produces.
+class StatusRegion {
+public:
+    StatusRegion(size_t visible, size_t history)
+        : visible_(std::max<size_t>(visible, 1)),
+          rows_(std::max(history, visible_)) {}
+
+    /// @brief Appends a status, evicting the oldest one when full
+    /// @return its id, also stored in the status
+    inline size_t Push(const IStatusPrint& status) {
+        if (rows_.full())
+            ++first_id_;
+        rows_.push_back(status);
+        rows_.back().id = first_id_ + rows_.size() - 1;
+        return rows_.back().id;
+    }
+
+    /// @brief Status of an id, nullptr once it left the history
+    inline IStatusPrint* Find(size_t id) {
+        if (id < first_id_ || id - first_id_ >= rows_.size())
+            return nullptr;
+        return &rows_[id - first_id_];
+    }
+
+    /// @brief Lines currently drawn, at most `visible`
+    inline size_t visible_count() const { return std::min(rows_.size(), visible_); }
+
+    /// @brief Id of the oldest drawn line, the next id when none is drawn
+    /// @param max as for ForEachVisible
+    inline size_t first_visible_id(size_t max = SIZE_MAX) const {
+        return first_id_ + rows_.size() - std::min(visible_count(), max);
+    }
+
+    /// @brief Calls fn(status) for each drawn line, oldest first
+    /// @param max fewer lines when the terminal is short, the newest are kept
+    template<typename Fn>
+    void ForEachVisible(Fn&& fn, size_t max = SIZE_MAX) const {
+        for (size_t i = rows_.size() - std::min(visible_count(), max); i < rows_.size(); ++i)
+            fn(rows_[i]);
+    }
+
+    /// @brief Copies up to `max` of the newest statuses, oldest first
+    inline std::vector<IStatusPrint> History(size_t max) const {
+        size_t count = std::min(max, rows_.size());
+        return std::vector<IStatusPrint>(rows_.end() - count, rows_.end());
+    }
+
+    inline size_t capacity() const { return rows_.capacity(); }
+
+private:
+    size_t visible_;
+    boost::circular_buffer<IStatusPrint> rows_;
+    /* id of rows_.front() */
+    size_t first_id_{0};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_STATUS_REGION_H_
@@ -0,0 +1,97 @@
+#ifndef CLARKESIM_SRC_COMMON_SYSTEM_LOG_H_
+#define CLARKESIM_SRC_COMMON_SYSTEM_LOG_H_
+
+#include <spdlog/async.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+#include <spdlog/spdlog.h>
+
+#include <fmt/format.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/// @brief Rotating system_log.csv behind an spdlog async logger
+///
+/// The console thread only formats a line and enqueues it; a dedicated
+/// spdlog thread pool does the file I/O. When the disk cannot keep up the
+/// bounded queue overwrites its oldest entries instead of blocking, so
+/// rendering latency does not depend on the disk. Table rows are only
+/// logged when ConsoleTablePrinter::setLogTelemetry is on, so by default
+/// the queue holds statuses, which a burst of samples cannot overrun.
+///
+/// CSV columns: time,level,source,header,message
+class SystemLog {
+public:
+    struct Options {
+        std::string path{"system_log.csv"};
+        size_t max_file_bytes{16u << 20};
+        size_t max_files{5};
+        size_t queue_size{8192};
+        size_t threads{1};
+        spdlog::async_overflow_policy overflow{spdlog::async_overflow_policy::overrun_oldest};
+    };
+
+    explicit SystemLog(const Options& options)
+        : pool_(std::make_shared<spdlog::details::thread_pool>(options.queue_size, options.threads)) {
+        sink_ = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+            options.path, options.max_file_bytes, options.max_files);
+        logger_ = std::make_shared<spdlog::async_logger>("system_log", sink_, pool_,
+                                                         options.overflow);
+        logger_->set_pattern("%Y-%m-%d %H:%M:%S.%e,%l,%v");
+        logger_->set_level(spdlog::level::debug);
+        logger_->flush_on(spdlog::level::warn);
+    }
+
+    /// @brief Drains the queue before the pool threads are joined
+    ~SystemLog() { logger_->flush(); }
+
+    /// @brief Writes out everything logged so far, for exit paths that do
+    /// not unwind (the pool threads never get joined there)
+    /// @return false when the queue did not drain within timeout
+    inline bool Flush(std::chrono::steady_clock::duration timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        logger_->flush(); // queued behind the pending lines
+        while (pool_->queue_size() > 0) {
+            if (std::chrono::steady_clock::now() >= deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        // waits for a write the pool thread may still be in
+        sink_->flush();
+        return true;
+    }
+
+    SystemLog(const SystemLog&) = delete;
+    SystemLog& operator=(const SystemLog&) = delete;
+
+    /// @brief Logger to hand to ConsoleTablePrinter, must not outlive this
+    inline std::shared_ptr<spdlog::logger> logger() const { return logger_; }
+
+    /// @brief Messages dropped because the queue was full
+    inline size_t overruns() const { return pool_->overrun_counter(); }
+
+private:
+    std::shared_ptr<spdlog::details::thread_pool> pool_;
+    std::shared_ptr<spdlog::sinks::rotating_file_sink_mt> sink_;
+    std::shared_ptr<spdlog::logger> logger_;
+};
+
+/// @brief Appends a CSV field, quoted only when it needs to be
+template<typename Buffer>
+inline void AppendCsvField(Buffer& out, std::string_view field) {
+    if (field.find_first_of(",\"\n") == std::string_view::npos) {
+        out.append(field.data(), field.data() + field.size());
+        return;
+    }
+    out.push_back('"');
+    for (char c : field) {
+        if (c == '"') out.push_back('"');
+        out.push_back(c);
+    }
+    out.push_back('"');
+}
+
+#endif  // CLARKESIM_SRC_COMMON_SYSTEM_LOG_H_
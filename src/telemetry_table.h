@@ -0,0 +1,204 @@
+#ifndef CLARKESIM_SRC_COMMON_TELEMETRY_TABLE_H_
+#define CLARKESIM_SRC_COMMON_TELEMETRY_TABLE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "console_base.h"
+#include "fast_format.h"
+
+/// @brief One column of a TelemetryTable, fixed at compile time
+///
+/// Derive a tag type and give it a name:
+///     struct Agl : TableColumn<double> { static constexpr std::string_view name = "Agl(m)"; };
+template<typename T,
+         ColumnAlign Align = ColumnAlign::Left,
+         size_t Width = 12,
+         int Precision = 2,
+         Aggregate Agg = Aggregate::Last>
+struct TableColumn {
+    static_assert(std::is_arithmetic_v<T>, "telemetry values must be numeric");
+    static_assert(Width > 0, "columns need at least one character");
+    static_assert(Precision >= 0 && Precision <= 9, "FormatFixed supports 0 to 9 decimals");
+    using type = T;
+    static constexpr ColumnAlign align = Align;
+    static constexpr size_t width = Width;
+    static constexpr int precision = Precision;
+    static constexpr Aggregate aggregate = Agg;
+};
+
+namespace telemetry_table {
+
+/// @brief "[" + width characters + "]", one table line
+template<size_t Width>
+using Line = std::array<char, Width + 2>;
+
+template<size_t Width>
+constexpr Line<Width> Filled(char fill) {
+    Line<Width> line{};
+    line[0] = '[';
+    for (size_t i = 1; i <= Width; ++i)
+        line[i] = fill;
+    line[Width + 1] = ']';
+    return line;
+}
+
+/// @brief Same placement as ConsoleTablePrinter::PlaceCell: cut to the
+/// column, centered text keeps the extra space on the right
+inline constexpr size_t CellPad(ColumnAlign align, size_t width, size_t len) {
+    return align == ColumnAlign::Center ? (width - len) / 2 : 0;
+}
+
+template<size_t Width>
+constexpr void Place(Line<Width>& line, size_t offset, ColumnAlign align, size_t width, std::string_view text) {
+    size_t len = std::min(text.size(), width);
+    size_t pad = CellPad(align, width, len);
+    for (size_t i = 0; i < len; ++i)
+        line[offset + pad + i] = text[i];
+}
+
+template<typename... Columns>
+constexpr std::array<size_t, sizeof...(Columns)> Offsets() {
+    std::array<size_t, sizeof...(Columns)> offsets{};
+    size_t widths[] = {Columns::width...};
+    size_t offset = 1; // skip the leading '['
+    for (size_t c = 0; c < sizeof...(Columns); ++c) {
+        offsets[c] = offset;
+        offset += widths[c];
+    }
+    return offsets;
+}
+
+template<size_t Width, typename... Columns>
+constexpr Line<Width> Header() {
+    Line<Width> line = Filled<Width>(' ');
+    auto offsets = Offsets<Columns...>();
+    size_t c = 0;
+    ((Place<Width>(line, offsets[c], Columns::align, Columns::width, Columns::name), ++c), ...);
+    return line;
+}
+
+}  // namespace telemetry_table
+
+/// @brief Telemetry table whose columns are types, see TableColumn
+///
+/// The header, separator and blank row are built at compile time, and
+/// rows are formatted by a function unrolled over the columns: no schema
+/// vector is walked and no alignment is looked up per cell. Rows are still
+/// TelemetrySamples, so recording, windows, the system log and ShmConsole
+/// see an ordinary schema; consoles that do not know StaticLayout (a
+/// viewer, a replay) format them through the runtime path instead.
+///
+///     using FlightTable = TelemetryTable<TimeS, Agl, Ias>;
+///     FlightTable flight(console);
+///     tm.PostSample(console, flight.Sample(t, agl, ias));
+template<typename... Columns>
+class TelemetryTable {
+public:
+    static_assert(sizeof...(Columns) > 0, "a table needs columns");
+    static_assert(sizeof...(Columns) <= kMaxTelemetryColumns, "too many columns for a TelemetrySample");
+
+    static constexpr size_t kColumns = sizeof...(Columns);
+    static constexpr size_t kWidth = (Columns::width + ...);
+    static constexpr size_t kLineSize = kWidth + 2;
+    using Row = std::tuple<typename Columns::type...>;
+
+    static constexpr telemetry_table::Line<kWidth> kSeparator = telemetry_table::Filled<kWidth>('=');
+    static constexpr telemetry_table::Line<kWidth> kBlankRow = telemetry_table::Filled<kWidth>(' ');
+    static constexpr telemetry_table::Line<kWidth> kHeader = telemetry_table::Header<kWidth, Columns...>();
+    static constexpr std::array<size_t, kColumns> kOffsets = telemetry_table::Offsets<Columns...>();
+    static constexpr std::array<size_t, kColumns> kWidths = {Columns::width...};
+
+    /// @param table rows go to this table of the console
+    explicit TelemetryTable(IConsole& console, TableId table = kDefaultTable)
+        : schema_(console.registerStaticSchema(Columns_(), std::max({Columns::precision...}), Layout())),
+          table_(table) {}
+
+    /// @brief A row for IConsole::addSample / ThreadManager::PostSample
+    inline TelemetrySample Sample(typename Columns::type... values) const {
+        TelemetrySample sample{schema_};
+        sample.table = table_;
+        (sample.push(values), ...);
+        return sample;
+    }
+
+    inline TelemetrySample Sample(const Row& row) const {
+        return std::apply([this](auto... values) { return Sample(values...); }, row);
+    }
+
+    inline SchemaHandle schema() const { return schema_; }
+    inline TableId table() const { return table_; }
+
+    /// @brief Writes the row of a sample, exactly kLineSize chars, into line
+    static void FormatRow(const TelemetrySample& sample, char* line) {
+        std::memcpy(line, kBlankRow.data(), kLineSize);
+        FormatCells(sample, line, std::index_sequence_for<Columns...>{});
+    }
+
+    /// @brief Text of one cell, cut to its column, into cell[kMaxCellChars]
+    static size_t FormatCell(const TelemetrySample& sample, size_t column, char* cell) {
+        return CellAt(sample, column, cell, std::index_sequence_for<Columns...>{});
+    }
+
+    static constexpr StaticLayout Layout() {
+        return {std::string_view(kHeader.data(), kLineSize),
+                std::string_view(kSeparator.data(), kLineSize),
+                std::string_view(kBlankRow.data(), kLineSize),
+                &FormatRow,
+                kWidths.data(),
+                &FormatCell};
+    }
+
+private:
+    /// @brief The same columns for everything that reads the runtime schema
+    static std::vector<Column> Columns_() {
+        return {Column{std::string(Columns::name), Columns::align, Columns::aggregate}...};
+    }
+
+    template<size_t... I>
+    static inline void FormatCells(const TelemetrySample& sample, char* line, std::index_sequence<I...>) {
+        (PlaceCell<Columns, I>(sample, line), ...);
+    }
+
+    template<size_t... I>
+    static inline size_t CellAt(const TelemetrySample& sample, size_t column, char* cell, std::index_sequence<I...>) {
+        size_t len = 0;
+        ((column == I && (len = CellText<Columns, I>(sample, cell), true)) || ...);
+        return len;
+    }
+
+    template<typename Col, size_t I>
+    static inline void PlaceCell(const TelemetrySample& sample, char* line) {
+        char cell[fast_format::kMaxCellChars];
+        size_t len = CellText<Col, I>(sample, cell);
+        std::memcpy(line + kOffsets[I] + telemetry_table::CellPad(Col::align, Col::width, len), cell, len);
+    }
+
+    /// @brief Value I of a sample as text, 0 chars when the sample is short
+    template<typename Col, size_t I>
+    static inline size_t CellText(const TelemetrySample& sample, char* cell) {
+        if (I >= sample.count)
+            return 0;
+        constexpr size_t kSize = fast_format::kMaxCellChars;
+        size_t len;
+        // windowed summaries of integer columns are doubles
+        if (std::is_integral_v<typename Col::type> && sample.is_int(I))
+            len = fast_format::FormatInt(sample.values[I].i, cell, kSize);
+        else if (sample.is_int(I))
+            len = fast_format::FormatFixed<Col::precision>(static_cast<double>(sample.values[I].i), cell, kSize);
+        else
+            len = fast_format::FormatFixed<Col::precision>(sample.values[I].f, cell, kSize);
+        return std::min({len, kSize, Col::width});
+    }
+
+    SchemaHandle schema_;
+    TableId table_;
+};
+
+#endif  // CLARKESIM_SRC_COMMON_TELEMETRY_TABLE_H_
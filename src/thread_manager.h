@@ -2,15 +2,21 @@
 #define CLARKESIM_SRC_COMMON_THREAD_MANAGER_C_
 
 #include <algorithm>
+#include <cassert>
 #include <functional>
 #include <thread>
 #include <vector>
 #include <mutex>
 #include <queue>
 #include <condition_variable>
+#include <deque>
 #include <map>
 #include <atomic>
 #include <shared_mutex>
+#include <variant>
+#include "console_base.h"
+#include "executor.h"
+#include "signal_watcher.h"
 
 
 /// @brief Simple class to disallow copying of derived classes
@@ -67,79 +73,136 @@ class ThreadSafe {
 };  // class ThreadSafe
 
 
-/// @brief  Decouples sim executor type from api
-/// concretely SingleThreadExecutor, potential multithreaded executor or synchronous in the future
-class SimExecutor {
-public:
-    using Task = std::function<void()>;
-    virtual ~SimExecutor() = default;
-    virtual void Post(Task task) = 0;
+/// @brief Queue implementation behind the console executor
+enum class ExecutorKind {
+    Blocking, /* SingleThreadExecutor, mutex + condition variable queue */
+    LockFree  /* MpscExecutor, bounded lock-free ring */
+};
+
+/// @brief What happens to telemetry posted between two frame ticks
+enum class CoalescePolicy {
+    KeepAll,   /* every sample enters the table history */
+    LatestOnly /* only the newest sample of each table is kept per frame */
+};
+
+/// @brief Console redraw rate, a rate of 0 redraws on every post
+struct ConsoleRefresh {
+    double rate_hz{30.0};
+    CoalescePolicy policy{CoalescePolicy::KeepAll};
 };
 
-class SingleThreadExecutor : public SimExecutor {
+/// @brief simple class for managing unnamed threads. threads added to the
+/// ThreadManager are moved, so thread variables added are no longer valid
+/// except in this object.
+class ThreadManager : private Uncopyable,
+                      private Unmovable {
+    using BatchItem = std::variant<ITelemetryPrint, TelemetrySample, IStatusPrint>;
+
 public:
-    SingleThreadExecutor()
-        : running_(true),
-          thread_(&SingleThreadExecutor::Run, this) {}
+    /// @brief Rows and statuses staged by one producer, posted as one task
+    ///
+    /// Items collect in a buffer owned by the calling thread and Commit (or
+    /// the destructor) hands them to the console thread as a single task:
+    /// they are applied back to back, so no frame shows half a batch, and
+    /// the console is redrawn once. One batch may be open per thread, and
+    /// only that thread may use it: the buffer is shared by every batch of
+    /// the thread (asserted in debug builds).
+    class Batch : private Uncopyable,
+                  private Unmovable {
+    public:
+        Batch(ThreadManager& tm, IConsole& console) : tm_(tm), console_(console) {
+            assert(Owner() == nullptr && "a ThreadManager::Batch is already open on this thread");
+            Owner() = this;
+        }
+        ~Batch() {
+            Commit();
+            Owner() = nullptr;
+        }
 
-    ~SingleThreadExecutor() override {
-        Stop();
-        if (thread_.joinable())
-            thread_.join();
-    }
+        inline Batch& Telem(ITelemetryPrint data) {
+            Staged().emplace_back(std::in_place_type<ITelemetryPrint>, std::move(data));
+            return *this;
+        }
 
-    void Post(Task task) override {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            queue_.push(std::move(task));
+        inline Batch& Sample(const TelemetrySample& sample) {
+            Staged().emplace_back(std::in_place_type<TelemetrySample>, sample);
+            return *this;
         }
-        cv_.notify_one();
-    }
 
-    void Stop() {
-        running_ = false;
-        cv_.notify_all();
-    }
+        inline Batch& Status(IStatusPrint data) {
+            Staged().emplace_back(std::in_place_type<IStatusPrint>, std::move(data));
+            has_status_ = true;
+            return *this;
+        }
 
-private:
-    void Run() {
-        while (true) {
-            Task task;
+        inline size_t size() const { return Staged().size(); }
 
-            {
-                std::unique_lock<std::mutex> lock(mutex_);
-                cv_.wait(lock, [&] {
-                    return !queue_.empty() || !running_;
-                });
+        /// @brief Posts everything staged so far, the batch can be reused
+        inline void Commit() {
+            std::vector<BatchItem>& staging = Staged();
+            if (staging.empty())
+                return;
+            // the staged items leave with the task, a recycled buffer takes their place
+            std::vector<BatchItem> items = tm_.TakeBatchBuffer();
+            items.swap(staging);
+            tm_.console_->Post([&tm = tm_, &con = console_, items = std::move(items)]() mutable {
+                tm.ApplyBatch(con, items);
+                tm.ReturnBatchBuffer(std::move(items));
+            }, has_status_ ? TaskClass::Status : TaskClass::Telemetry);
+            has_status_ = false;
+        }
 
-                if (!running_ && queue_.empty())
-                    return;
+    private:
+        static inline std::vector<BatchItem>& Staging() {
+            static thread_local std::vector<BatchItem> staging;
+            return staging;
+        }
 
-                task = std::move(queue_.front());
-                queue_.pop();
-            }
+        /// @brief The open batch of this thread, the one Staging() belongs to
+        static inline const Batch*& Owner() {
+            static thread_local const Batch* owner = nullptr;
+            return owner;
+        }
 
-            task();
+        /// @brief Staging(), checked to be this batch's on this thread
+        inline std::vector<BatchItem>& Staged() const {
+            assert(Owner() == this && "a ThreadManager::Batch is used off the thread that opened it");
+            return Staging();
         }
-    }
 
-    std::queue<Task> queue_;
-    std::mutex mutex_;
-    std::condition_variable cv_;
-    std::atomic<bool> running_;
-    std::thread thread_;
-};
+        ThreadManager& tm_;
+        IConsole& console_;
+        /* statuses are never dropped, telemetry-only batches may be */
+        bool has_status_{false};
+    };
 
-/// @brief simple class for managing unnamed threads. threads added to the
-/// ThreadManager are moved, so thread variables added are no longer valid
-/// except in this object.
-class ThreadManager : private Uncopyable,
-                      private Unmovable {
-public:
-    ThreadManager() {
-        console_ = std::make_unique<SingleThreadExecutor>();
+    /// @param limits bounds of the console queue, by default a stalled
+    /// terminal sheds the oldest telemetry instead of growing the queue;
+    /// ExecutorKind::LockFree needs DropNewest or Wait (see MpscExecutor)
+    explicit ThreadManager(ExecutorKind kind = ExecutorKind::Blocking,
+                           ConsoleRefresh refresh = {},
+                           QueueLimits limits = {})
+        : refresh_(refresh) {
+        if (kind == ExecutorKind::LockFree)
+            console_ = std::make_unique<MpscExecutor>(kMpscSlots, std::move(limits));
+        else
+            console_ = std::make_unique<SingleThreadExecutor>(std::move(limits));
+
+        // the tick also steps polling animations, so it runs uncapped too
+        std::chrono::duration<double> period = std::chrono::milliseconds(kAnimationTickMs);
+        if (FrameCapped())
+            period = std::chrono::duration<double>(1.0 / refresh_.rate_hz);
+        console_->SetTick(std::chrono::duration_cast<std::chrono::nanoseconds>(period),
+                          [this] { FlushFrames(); });
+    }
+    ~ThreadManager() {
+        resize_watcher_.reset(); // posts into console_
+        Join();
+        // draw whatever the last frame tick did not get to, then drain
+        // (dropped after Shutdown, whose last tick already did)
+        console_->Post([this] { FlushFrames(); }, TaskClass::Status);
+        console_.reset();
     }
-    ~ThreadManager() { Join(); }
 
     /// @brief add the thread represented by t to the threads managed by this
     /// object
@@ -153,35 +216,238 @@ public:
     }
 
     inline void PostTelem(std::reference_wrapper<IConsole> obj, ITelemetryPrint data) {
-        console_->Post([obj, data = std::move(data)] {
-            auto con = obj.get().addTelemetry(std::move(data));
-            obj.get().printTelemTable(con);
-        });
+        console_->Post([this, obj, data = std::move(data)]() mutable {
+            TableId table = data.table;
+            ApplyTelem(obj.get(), table, [obj, data = std::move(data)]() mutable {
+                return obj.get().addTelemetry(std::move(data));
+            });
+        }, TaskClass::Telemetry);
+    }
+
+    /// @brief Posts a typed row for a schema from IConsole::registerSchema
+    inline void PostSample(std::reference_wrapper<IConsole> obj, const TelemetrySample& sample) {
+        console_->Post([this, obj, sample] {
+            ApplyTelem(obj.get(), sample.table, [obj, sample] {
+                return obj.get().addSample(sample);
+            });
+        }, TaskClass::Telemetry);
     }
 
     inline void PostStatus(std::reference_wrapper<IConsole> obj, IStatusPrint data) {
-        console_->Post([obj, data = std::move(data)] {
+        console_->Post([this, obj, data = std::move(data)] {
             obj.get().newStatus(data);
+            Redraw(obj.get());
         });
     }
 
     inline void PollStatus(std::reference_wrapper<IConsole> obj, IStatusPrint data,
                         std::function<void(size_t)> callback) {
-        console_->Post([obj, data = std::move(data), callback = std::move(callback)]() mutable {
+        console_->Post([this, obj, data = std::move(data), callback = std::move(callback)]() mutable {
             size_t id = obj.get().startPolling(data);
+            Redraw(obj.get());
             if (callback) callback(id);
-        });
+        }, TaskClass::Control);
     }
 
     inline void HaultPolledStatus(std::reference_wrapper<IConsole> obj, size_t id, IStatusPrint data) {
-        console_->Post([obj, id = std::move(id), data = std::move(data)] {
+        console_->Post([this, obj, id = std::move(id), data = std::move(data)] {
             obj.get().stopPolling(id, data);
+            Redraw(obj.get());
+        }, TaskClass::Control);
+    }
+
+    /// @brief Opens a batch for obj, committed when it goes out of scope
+    /// e.g. auto batch = tm.BeginBatch(console); batch.Sample(a).Sample(b);
+    inline Batch BeginBatch(std::reference_wrapper<IConsole> obj) { return Batch(*this, obj.get()); }
+
+    /// @brief Runs fn(console) on the console thread, then redraws it
+    /// For callers that need several IConsole calls to see each other's
+    /// results, e.g. a status id returned by startPolling
+    template<typename Fn>
+    inline void PostUpdate(std::reference_wrapper<IConsole> obj, Fn fn) {
+        console_->Post([this, obj, fn = std::move(fn)]() mutable {
+            fn(obj.get());
+            Redraw(obj.get());
+        });
+    }
+
+    /// @brief Refits obj to the terminal after every SIGWINCH
+    /// The signal only wakes a watcher thread, which posts the resize as a
+    /// control task: the console re-reads its size on its own thread and is
+    /// repainted in full, the only full redraw it gets
+    inline void WatchResize(std::reference_wrapper<IConsole> obj) {
+        resize_watcher_ = std::make_unique<SignalWatcher>(std::vector<int>{SIGWINCH}, [this, obj](int) {
+            console_->Post([this, obj] {
+                Redraw(obj.get(), obj.get().terminalResized());
+            }, TaskClass::Control);
         });
     }
 
+    /// @brief Stops the console within timeout, e.g. on SIGINT
+    ///
+    /// Posts are dropped from now on and Stopping() turns true, so producer
+    /// threads can wind down. What is already queued is drawn, followed by
+    /// one last frame, unless the timeout runs out first: the rest is then
+    /// dropped and Shutdown returns anyway, even with a task stuck on the
+    /// terminal. Producer threads are not joined. Not for the console
+    /// thread itself (a posted task).
+    inline ShutdownStats Shutdown(std::chrono::steady_clock::duration timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        if (!stopping_.exchange(true, std::memory_order_relaxed))
+            resize_watcher_.reset();
+        return console_->Shutdown(deadline);
+    }
+
+    /// @brief Shutdown was called, producers should stop posting
+    inline bool Stopping() const { return stopping_.load(std::memory_order_relaxed); }
+
+    /// @brief Telemetry samples that were merged into another sample's frame
+    /// (KeepAll) or replaced by a newer sample before being drawn (LatestOnly)
+    inline size_t CoalescedSamples() const { return coalesced_.load(std::memory_order_relaxed); }
+
+    /// @brief Console queue depth, drops and latency, callable from any thread
+    inline QueueStats ExecutorStats() const { return console_->Stats(); }
+
 private:
+    /// @brief Redraw state of one console, only touched on the executor thread
+    struct PendingFrame {
+        /// @brief LatestOnly: newest telemetry of one table
+        struct Latest {
+            TableId table;
+            SmallTask add;
+        };
+
+        IConsole* console;
+        bool dirty{false};
+        bool full_redraw{false};
+        /* LatestOnly: one row per table, applied when the frame is drawn */
+        std::vector<Latest> latest{};
+    };
+
+    static constexpr int kAnimationTickMs = 50;
+    static constexpr size_t kMpscSlots = 1024;
+    static constexpr size_t kMaxBatchBuffers = 8;
+
+    inline bool FrameCapped() const { return refresh_.rate_hz > 0; }
+
+    inline PendingFrame& Frame(IConsole& con) {
+        for (auto& frame : frames_)
+            if (frame.console == &con) return frame;
+        frames_.push_back({&con});
+        return frames_.back();
+    }
+
+    /// @brief Redraws now, or on the next frame tick when the rate is capped
+    inline void Redraw(IConsole& con, bool full_redraw = false) {
+        PendingFrame& frame = Frame(con); // known to the tick even uncapped
+        if (!FrameCapped()) {
+            con.printTelemTable(full_redraw);
+            return;
+        }
+        frame.dirty = true;
+        frame.full_redraw |= full_redraw;
+    }
+
+    /// @brief Merges a telemetry post into the pending frame of its console
+    /// @param add applies the sample, returns IConsole's full redraw hint
+    template<typename Add>
+    inline void ApplyTelem(IConsole& con, TableId table, Add add) {
+        PendingFrame& frame = Frame(con);
+        if (!FrameCapped()) {
+            con.printTelemTable(add());
+            return;
+        }
+        if (refresh_.policy == CoalescePolicy::LatestOnly) {
+            auto pending = std::find_if(frame.latest.begin(), frame.latest.end(),
+                                        [table](const PendingFrame::Latest& l) { return l.table == table; });
+            if (pending == frame.latest.end()) {
+                frame.latest.push_back(PendingFrame::Latest{table, SmallTask{}});
+                pending = std::prev(frame.latest.end());
+            } else {
+                coalesced_.fetch_add(1, std::memory_order_relaxed);
+            }
+            pending->add = [&frame, add = std::move(add)]() mutable { frame.full_redraw |= add(); };
+        } else {
+            if (frame.dirty) coalesced_.fetch_add(1, std::memory_order_relaxed);
+            frame.full_redraw |= add();
+        }
+        frame.dirty = true;
+    }
+
+    /// @brief Applies the LatestOnly rows held back for the frame
+    /// The vector keeps its capacity, a frame usually sees the same tables
+    static inline void ApplyLatest(PendingFrame& frame) {
+        for (auto& pending : frame.latest)
+            pending.add();
+        frame.latest.clear();
+    }
+
+    /// @brief Applies a committed batch in order, then redraws once
+    inline void ApplyBatch(IConsole& con, std::vector<BatchItem>& items) {
+        PendingFrame& frame = Frame(con);
+        // an older LatestOnly row must not land after the batch's rows
+        ApplyLatest(frame);
+        bool full_redraw = false;
+        size_t rows = 0;
+        for (auto& item : items) {
+            if (auto* telem = std::get_if<ITelemetryPrint>(&item)) {
+                full_redraw |= con.addTelemetry(std::move(*telem));
+                ++rows;
+            } else if (auto* sample = std::get_if<TelemetrySample>(&item)) {
+                full_redraw |= con.addSample(*sample);
+                ++rows;
+            } else {
+                con.newStatus(std::get<IStatusPrint>(item));
+            }
+        }
+        if (FrameCapped() && rows > 0)
+            coalesced_.fetch_add(frame.dirty ? rows : rows - 1, std::memory_order_relaxed);
+        Redraw(con, full_redraw);
+    }
+
+    /// @brief An empty buffer for the next batch, with capacity when one was returned
+    inline std::vector<BatchItem> TakeBatchBuffer() {
+        std::lock_guard<std::mutex> lock(batch_buffers_mutex_);
+        if (batch_buffers_.empty())
+            return {};
+        std::vector<BatchItem> buffer = std::move(batch_buffers_.back());
+        batch_buffers_.pop_back();
+        return buffer;
+    }
+
+    inline void ReturnBatchBuffer(std::vector<BatchItem>&& buffer) {
+        buffer.clear();
+        std::lock_guard<std::mutex> lock(batch_buffers_mutex_);
+        if (batch_buffers_.size() < kMaxBatchBuffers)
+            batch_buffers_.push_back(std::move(buffer));
+    }
+
+    /// @brief Frame tick, one redraw per console that changed since the last
+    inline void FlushFrames() {
+        auto now = std::chrono::steady_clock::now();
+        for (auto& frame : frames_) {
+            // animations and rate capped tables move without new posts
+            if (frame.console->advanceAnimations(now))
+                frame.dirty = true;
+            if (!frame.dirty) continue;
+            ApplyLatest(frame);
+            frame.console->printTelemTable(frame.full_redraw);
+            frame.dirty = false;
+            frame.full_redraw = false;
+        }
+    }
+
     std::vector<std::thread> threads_{};
+    ConsoleRefresh refresh_;
+    /* Deque keeps PendingFrame references stable for the latest tasks */
+    std::deque<PendingFrame> frames_{};
+    std::atomic<size_t> coalesced_{0};
+    std::atomic<bool> stopping_{false};
+    /* Committed batch buffers handed back by the console thread for reuse */
+    std::mutex batch_buffers_mutex_;
+    std::vector<std::vector<BatchItem>> batch_buffers_{};
     std::unique_ptr<SimExecutor> console_;
+    std::unique_ptr<SignalWatcher> resize_watcher_{};
 
 };
-#endif  // CLARKESIM_SRC_COMMON_THREAD_MANAGER_H_
\ No newline at end of file
+#endif  // CLARKESIM_SRC_COMMON_THREAD_MANAGER_H_
@@ -0,0 +1,67 @@
+#ifndef CLARKESIM_SRC_COMMON_TIMER_WHEEL_H_
+#define CLARKESIM_SRC_COMMON_TIMER_WHEEL_H_
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+/// @brief Hashed timer wheel of ids, driven by an external clock
+///
+/// Schedule is O(1). Cancelling is left to the owner: ids whose timer no
+/// longer matters are simply ignored by the Advance callback (lazy delete),
+/// so a stop never has to search the wheel.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TimerWheel(std::chrono::milliseconds tick, size_t slots = 16)
+        : tick_(tick), slots_(slots) {}
+
+    /// @brief Fires id after `ticks` wheel ticks (at least one)
+    inline void Schedule(size_t id, size_t ticks = 1) {
+        if (ticks == 0) ticks = 1;
+        if (ticks >= slots_.size()) ticks = slots_.size() - 1;
+        slots_[(cursor_ + ticks) % slots_.size()].push_back(id);
+        ++pending_;
+    }
+
+    inline bool empty() const { return pending_ == 0; }
+
+    /// @brief Moves the wheel up to now and calls fire(id) for each expired id
+    /// @return number of ids fired
+    template<typename Fire>
+    size_t Advance(Clock::time_point now, Fire&& fire) {
+        if (started_ == Clock::time_point{})
+            started_ = now;
+        size_t target = static_cast<size_t>((now - started_) / tick_);
+        // a long stall only needs one lap of the wheel
+        if (target - ticks_ > slots_.size())
+            ticks_ = target - slots_.size();
+
+        size_t fired = 0;
+        while (ticks_ < target) {
+            ++ticks_;
+            cursor_ = ticks_ % slots_.size();
+            // fire may re-schedule into other slots, never into this one
+            expired_.swap(slots_[cursor_]);
+            for (size_t id : expired_) {
+                --pending_;
+                fire(id);
+                ++fired;
+            }
+            expired_.clear();
+        }
+        return fired;
+    }
+
+private:
+    Clock::duration tick_;
+    std::vector<std::vector<size_t>> slots_;
+    std::vector<size_t> expired_{};
+    Clock::time_point started_{};
+    size_t ticks_{0};
+    size_t cursor_{0};
+    size_t pending_{0};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_TIMER_WHEEL_H_
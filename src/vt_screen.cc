@@ -0,0 +1,268 @@
+#include "vt_screen.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+VtScreen::VtScreen(size_t columns, size_t rows)
+    : columns_(std::max<size_t>(columns, 1)),
+      rows_(std::max<size_t>(rows, 1)),
+      grid_(rows_, std::vector<VtCell>(columns_)) {}
+
+bool operator==(const VtScreen& a, const VtScreen& b){
+    return a.row_ == b.row_ && a.column_ == b.column_ && a.grid_ == b.grid_;
+}
+
+void VtScreen::Feed(std::string_view bytes){
+    for (char ch : bytes){
+        auto byte = static_cast<unsigned char>(ch);
+        switch (state_){
+        case State::Escape:
+            if (ch == '['){
+                state_ = State::Csi;
+                params_.clear();
+            } else {
+                ++unsupported_; // ESC 7, ESC M, ... are not used by the console
+                state_ = State::Ground;
+            }
+            continue;
+        case State::Csi:
+            if (byte >= 0x40 && byte <= 0x7e){
+                Dispatch(ch);
+                state_ = State::Ground;
+            } else {
+                params_ += ch;
+            }
+            continue;
+        case State::Ground:
+            break;
+        }
+
+        if (utf8_left_ > 0){
+            if ((byte & 0xC0) == 0x80){
+                utf8_ += ch;
+                if (--utf8_left_ == 0)
+                    Print(utf8_);
+                continue;
+            }
+            // cut sequence: shown as one replacement cell, ch is read anew
+            utf8_left_ = 0;
+            Print("\xEF\xBF\xBD");
+        }
+        if (ch == '\033'){
+            state_ = State::Escape;
+        } else if (byte < 0x20 || byte == 0x7f){
+            Control(ch);
+        } else if (byte < 0x80){
+            Print(std::string_view(&ch, 1));
+        } else {
+            utf8_.assign(1, ch);
+            utf8_left_ = byte >= 0xF0 ? 3 : byte >= 0xE0 ? 2 : byte >= 0xC0 ? 1 : 0;
+            if (utf8_left_ == 0)
+                Print("\xEF\xBF\xBD"); // stray continuation byte
+        }
+    }
+}
+
+void VtScreen::Print(std::string_view glyph){
+    if (wrap_pending_){
+        column_ = 0;
+        LineFeed();
+    }
+    VtCell& cell = grid_[row_][column_];
+    cell.glyph.assign(glyph.data(), glyph.size());
+    cell.color = color_;
+    if (column_ + 1 < columns_)
+        ++column_;
+    else
+        wrap_pending_ = true;
+}
+
+void VtScreen::Control(char ch){
+    switch (ch){
+    case '\r':
+        column_ = 0;
+        break;
+    case '\n':
+        LineFeed();
+        break;
+    case '\b':
+        if (column_ > 0) --column_;
+        break;
+    case '\t':
+        column_ = std::min(columns_ - 1, (column_ / 8 + 1) * 8);
+        break;
+    case '\a':
+        return;
+    default:
+        ++unsupported_;
+        return;
+    }
+    wrap_pending_ = false;
+}
+
+void VtScreen::LineFeed(){
+    wrap_pending_ = false;
+    if (row_ + 1 < rows_){
+        ++row_;
+        return;
+    }
+    grid_.erase(grid_.begin());
+    grid_.emplace_back(columns_);
+    ++scrolled_;
+}
+
+size_t VtScreen::Param(size_t n, size_t fallback) const{
+    size_t start = 0;
+    for (size_t i = 0; i < n; ++i){
+        start = params_.find(';', start);
+        if (start == std::string::npos)
+            return fallback;
+        ++start;
+    }
+    size_t value = std::strtoul(params_.c_str() + start, nullptr, 10);
+    return value == 0 ? fallback : value;
+}
+
+void VtScreen::Dispatch(char final){
+    bool private_mode = !params_.empty() && params_[0] == '?';
+    if (private_mode){
+        if ((final == 'h' || final == 'l') && params_ == "?25")
+            cursor_visible_ = final == 'h';
+        else
+            ++unsupported_;
+        return;
+    }
+    wrap_pending_ = false;
+    switch (final){
+    case 'A':
+        row_ -= std::min(row_, Param(0, 1));
+        break;
+    case 'B':
+        row_ = std::min(rows_ - 1, row_ + Param(0, 1));
+        break;
+    case 'C':
+        column_ = std::min(columns_ - 1, column_ + Param(0, 1));
+        break;
+    case 'D':
+        column_ -= std::min(column_, Param(0, 1));
+        break;
+    case 'H':
+    case 'f':
+        row_ = std::min(rows_, Param(0, 1)) - 1;
+        column_ = std::min(columns_, Param(1, 1)) - 1;
+        break;
+    case 'K':
+        switch (Param(0, 0)){
+        case 0: EraseRow(row_, column_, columns_); break;
+        case 1: EraseRow(row_, 0, column_ + 1); break;
+        case 2: EraseRow(row_, 0, columns_); break;
+        default: ++unsupported_;
+        }
+        break;
+    case 'J':
+        switch (Param(0, 0)){
+        case 0:
+            EraseRow(row_, column_, columns_);
+            for (size_t r = row_ + 1; r < rows_; ++r)
+                EraseRow(r, 0, columns_);
+            break;
+        case 1:
+            for (size_t r = 0; r < row_; ++r)
+                EraseRow(r, 0, columns_);
+            EraseRow(row_, 0, column_ + 1);
+            break;
+        case 2:
+            for (size_t r = 0; r < rows_; ++r)
+                EraseRow(r, 0, columns_);
+            break;
+        default: ++unsupported_;
+        }
+        break;
+    case 'm':
+        SelectGraphics();
+        break;
+    default:
+        ++unsupported_;
+    }
+}
+
+void VtScreen::SelectGraphics(){
+    // only the foreground is modeled, other attributes are accepted
+    for (size_t start = 0;;){
+        size_t code = std::strtoul(params_.c_str() + start, nullptr, 10);
+        if (code == 0 || code == 39)
+            color_ = 0;
+        else if (code >= 30 && code <= 37)
+            color_ = static_cast<uint8_t>(code);
+        start = params_.find(';', start);
+        if (start == std::string::npos)
+            return;
+        ++start;
+    }
+}
+
+void VtScreen::EraseRow(size_t row, size_t from, size_t to){
+    for (size_t c = from; c < std::min(to, columns_); ++c)
+        grid_[row][c] = VtCell{};
+}
+
+void VtScreen::Resize(size_t columns, size_t rows){
+    columns = std::max<size_t>(columns, 1);
+    rows = std::max<size_t>(rows, 1);
+    // a shorter window keeps the cursor row on screen
+    if (row_ >= rows){
+        size_t drop = row_ + 1 - rows;
+        grid_.erase(grid_.begin(), grid_.begin() + drop);
+        scrolled_ += drop;
+        row_ -= drop;
+    }
+    grid_.resize(rows);
+    for (auto& line : grid_)
+        line.resize(columns);
+    columns_ = columns;
+    rows_ = rows;
+    column_ = std::min(column_, columns_ - 1);
+    wrap_pending_ = false;
+}
+
+std::string VtScreen::Row(size_t row) const{
+    std::string text;
+    size_t end = columns_;
+    while (end > 0 && grid_[row][end - 1] == VtCell{})
+        --end;
+    for (size_t c = 0; c < end; ++c)
+        text += grid_[row][c].glyph;
+    return text;
+}
+
+std::string VtScreen::Text() const{
+    std::string text;
+    for (size_t r = 0; r < rows_; ++r){
+        if (r > 0) text += '\n';
+        text += Row(r);
+    }
+    return text;
+}
+
+std::string VtScreen::Dump() const{
+    // colored runs as {31:text}, the cursor as a '|' before its cell
+    std::string text;
+    for (size_t r = 0; r < rows_; ++r){
+        uint8_t color = 0;
+        for (size_t c = 0; c < columns_; ++c){
+            const VtCell& cell = grid_[r][c];
+            if (cell.color != color){
+                if (color != 0) text += '}';
+                if (cell.color != 0) text += "{" + std::to_string(cell.color) + ":";
+                color = cell.color;
+            }
+            if (r == row_ && c == column_)
+                text += '|';
+            text += cell.glyph;
+        }
+        if (color != 0) text += '}';
+        text.erase(text.find_last_not_of(' ') + 1);
+        text += '\n';
+    }
+    return text;
+}
@@ -0,0 +1,97 @@
+#ifndef CLARKESIM_SRC_COMMON_VT_SCREEN_H_
+#define CLARKESIM_SRC_COMMON_VT_SCREEN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @brief One character cell of a VtScreen
+struct VtCell {
+    /* One UTF-8 encoded character, a space when blank */
+    std::string glyph{" "};
+    /* SGR foreground: 0 for the default color, 30..37 otherwise */
+    uint8_t color{0};
+
+    friend inline bool operator==(const VtCell& a, const VtCell& b) {
+        return a.color == b.color && a.glyph == b.glyph;
+    }
+    friend inline bool operator!=(const VtCell& a, const VtCell& b) { return !(a == b); }
+};
+
+/// @brief In-process model of the VT100 subset the console writes
+///
+/// Feed it everything an OutputSink received (CaptureSink::text()) and it
+/// holds the character grid a terminal of that size would show: printable
+/// UTF-8 with xterm's deferred wrap at the right margin, CR, LF (scrolling
+/// at the bottom), BS, TAB, and the CSI sequences A B C D H f J K m and
+/// ?25h/l. Anything else is counted in unsupported() and otherwise
+/// ignored, so a test notices the console emitting a sequence the model
+/// does not interpret. An escape split across two Feed calls is resumed.
+class VtScreen {
+public:
+    VtScreen(size_t columns, size_t rows);
+
+    /// @brief Interprets the bytes as the terminal would
+    void Feed(std::string_view bytes);
+
+    /// @brief Changes the grid without reflowing it, like xterm: rows and
+    /// columns are cut or padded, rows above the cursor are dropped first
+    void Resize(size_t columns, size_t rows);
+
+    /// @brief Glyphs of one row, trailing blanks removed
+    std::string Row(size_t row) const;
+    /// @brief Every row, trailing blanks removed, joined by '\n'
+    std::string Text() const;
+    /// @brief Text() with the colored cells marked, for failure messages
+    std::string Dump() const;
+
+    inline const VtCell& Cell(size_t row, size_t column) const { return grid_[row][column]; }
+    inline size_t columns() const { return columns_; }
+    inline size_t rows() const { return rows_; }
+    inline size_t cursorRow() const { return row_; }
+    inline size_t cursorColumn() const { return column_; }
+    inline bool cursorVisible() const { return cursor_visible_; }
+    /// @brief Lines pushed off the top by a LF on the last row
+    inline size_t scrolled() const { return scrolled_; }
+    /// @brief Control bytes and escapes that were not interpreted
+    inline size_t unsupported() const { return unsupported_; }
+
+    /// @brief Same cells and cursor position
+    friend bool operator==(const VtScreen& a, const VtScreen& b);
+    friend inline bool operator!=(const VtScreen& a, const VtScreen& b) { return !(a == b); }
+
+private:
+    enum class State { Ground, Escape, Csi };
+
+    void Print(std::string_view glyph);
+    void Control(char ch);
+    void Dispatch(char final);
+    void LineFeed();
+    void SelectGraphics();
+    /// @brief Blanks columns [from, to) of a row
+    void EraseRow(size_t row, size_t from, size_t to);
+    /// @brief Numeric parameter n of the current CSI, fallback when absent or 0
+    size_t Param(size_t n, size_t fallback) const;
+
+    size_t columns_;
+    size_t rows_;
+    std::vector<std::vector<VtCell>> grid_;
+    size_t row_{0};
+    size_t column_{0};
+    /* The last column was written, the next glyph goes to the next line */
+    bool wrap_pending_{false};
+    uint8_t color_{0};
+    bool cursor_visible_{true};
+    size_t scrolled_{0};
+    size_t unsupported_{0};
+
+    /* Parser state kept between Feed calls */
+    State state_{State::Ground};
+    std::string params_{};
+    std::string utf8_{};
+    size_t utf8_left_{0};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_VT_SCREEN_H_
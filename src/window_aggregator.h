@@ -0,0 +1,133 @@
+#ifndef CLARKESIM_SRC_COMMON_WINDOW_AGGREGATOR_H_
+#define CLARKESIM_SRC_COMMON_WINDOW_AGGREGATOR_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "console_base.h"
+
+/// @brief Running min/max/mean/stddev/rate/last of every column of a window
+///
+/// Add is O(columns) per sample and never looks back at earlier samples:
+/// mean and variance use Welford's update, min/max/first/last are single
+/// compares. State is kept as one array per statistic and every update is
+/// a straight loop over the columns, so the compiler can vectorize it
+/// across the 30+ channels of a wide row. Integer columns also keep
+/// first/last/min/max as int64_t, since the double copy rounds above 2^53
+/// (nanosecond timestamps, counters).
+class WindowAggregator {
+public:
+    inline void Reset() { count_ = 0; columns_ = 0; int_mask_ = 0; }
+
+    inline size_t count() const { return count_; }
+
+    /// @param time_s arrival time of the sample, used by Aggregate::Rate
+    inline void Add(const TelemetrySample& sample, double time_s) {
+        size_t columns = std::min<size_t>(sample.count, kMaxTelemetryColumns);
+        for (size_t c = 0; c < columns; ++c)
+            x_[c] = sample.values[c].f;
+        uint32_t int_mask = columns < 32 ? sample.int_mask & ((1u << columns) - 1) : sample.int_mask;
+        for (uint32_t ints = int_mask; ints != 0; ints &= ints - 1) {
+            size_t c = static_cast<size_t>(__builtin_ctz(ints));
+            x_[c] = static_cast<double>(sample.values[c].i);
+        }
+
+        // a change of column types restarts the window like a change of width
+        if (count_ == 0 || columns != columns_ || int_mask != int_mask_) {
+            count_ = 0;
+            columns_ = columns;
+            int_mask_ = int_mask;
+            first_time_ = time_s;
+            for (size_t c = 0; c < columns; ++c) {
+                first_[c] = min_[c] = max_[c] = x_[c];
+                mean_[c] = m2_[c] = 0.0;
+            }
+            for (uint32_t ints = int_mask; ints != 0; ints &= ints - 1) {
+                size_t c = static_cast<size_t>(__builtin_ctz(ints));
+                int_first_[c] = int_min_[c] = int_max_[c] = sample.values[c].i;
+            }
+        }
+        last_time_ = time_s;
+        for (uint32_t ints = int_mask; ints != 0; ints &= ints - 1) {
+            size_t c = static_cast<size_t>(__builtin_ctz(ints));
+            int64_t i = sample.values[c].i;
+            int_min_[c] = std::min(int_min_[c], i);
+            int_max_[c] = std::max(int_max_[c], i);
+            int_last_[c] = i;
+        }
+
+        ++count_;
+        const double inv = 1.0 / static_cast<double>(count_);
+        for (size_t c = 0; c < columns; ++c) {
+            double delta = x_[c] - mean_[c];
+            mean_[c] += delta * inv;
+            m2_[c] += delta * (x_[c] - mean_[c]);
+            min_[c] = std::min(min_[c], x_[c]);
+            max_[c] = std::max(max_[c], x_[c]);
+            last_[c] = x_[c];
+        }
+    }
+
+    /// @brief Writes one summary value per column, picked by column.aggregate
+    /// Last/Min/Max of integer columns stay exact integers
+    inline void Summarize(const std::vector<Column>& columns, TelemetrySample& out) const {
+        out.count = static_cast<uint32_t>(columns_);
+        out.int_mask = 0;
+        double span = last_time_ - first_time_;
+        for (size_t c = 0; c < columns_; ++c) {
+            Aggregate aggregate = c < columns.size() ? columns[c].aggregate : Aggregate::Last;
+            double v = last_[c];
+            switch (aggregate) {
+                case Aggregate::Last:   v = last_[c]; break;
+                case Aggregate::Min:    v = min_[c]; break;
+                case Aggregate::Max:    v = max_[c]; break;
+                case Aggregate::Mean:   v = mean_[c]; break;
+                case Aggregate::StdDev: v = std::sqrt(m2_[c] / static_cast<double>(count_)); break;
+                case Aggregate::Rate:   v = span > 0 ? (last_[c] - first_[c]) / span : 0.0; break;
+            }
+            if ((int_mask_ >> c) & 1u) {
+                switch (aggregate) {
+                    case Aggregate::Last: out.values[c].i = int_last_[c]; break;
+                    case Aggregate::Min:  out.values[c].i = int_min_[c]; break;
+                    case Aggregate::Max:  out.values[c].i = int_max_[c]; break;
+                    case Aggregate::Rate: {
+                        // difference taken in integers, wrapping like the counter would
+                        int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(int_last_[c]) -
+                                                             static_cast<uint64_t>(int_first_[c]));
+                        out.values[c].f = span > 0 ? static_cast<double>(delta) / span : 0.0;
+                        continue;
+                    }
+                    default: out.values[c].f = v; continue;
+                }
+                out.int_mask |= 1u << c;
+            } else {
+                out.values[c].f = v;
+            }
+        }
+    }
+
+private:
+    size_t count_{0};
+    size_t columns_{0};
+    uint32_t int_mask_{0};
+    double first_time_{0.0};
+    double last_time_{0.0};
+    /* one array per statistic, indexed by column */
+    alignas(64) std::array<double, kMaxTelemetryColumns> x_{};
+    alignas(64) std::array<double, kMaxTelemetryColumns> first_{};
+    alignas(64) std::array<double, kMaxTelemetryColumns> last_{};
+    alignas(64) std::array<double, kMaxTelemetryColumns> min_{};
+    alignas(64) std::array<double, kMaxTelemetryColumns> max_{};
+    alignas(64) std::array<double, kMaxTelemetryColumns> mean_{};
+    alignas(64) std::array<double, kMaxTelemetryColumns> m2_{};
+    /* exact copies for the columns set in int_mask_ */
+    alignas(64) std::array<int64_t, kMaxTelemetryColumns> int_first_{};
+    alignas(64) std::array<int64_t, kMaxTelemetryColumns> int_last_{};
+    alignas(64) std::array<int64_t, kMaxTelemetryColumns> int_min_{};
+    alignas(64) std::array<int64_t, kMaxTelemetryColumns> int_max_{};
+};
+
+#endif  // CLARKESIM_SRC_COMMON_WINDOW_AGGREGATOR_H_
@@ -0,0 +1,544 @@
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <variant>
+#include <vector>
+#include "console.h"
+#include "vt_screen.h"
+
+// ----------------------------------------------------------------------------
+// VtScreen on its own: the sequences the console relies on
+// ----------------------------------------------------------------------------
+
+TEST(VtScreen, WrapIsDeferredAtTheRightMargin) {
+    VtScreen screen(4, 3);
+    screen.Feed("abcd");
+    EXPECT_EQ(screen.cursorRow(), 0u);
+    EXPECT_EQ(screen.cursorColumn(), 3u);
+    // a full line followed by CR LF does not leave an empty line behind
+    screen.Feed("\r\nef");
+    EXPECT_EQ(screen.Text(), "abcd\nef\n");
+    screen.Feed("ghij");
+    EXPECT_EQ(screen.Text(), "abcd\nefgh\nij");
+}
+
+TEST(VtScreen, LineFeedScrollsAtTheBottom) {
+    VtScreen screen(5, 2);
+    screen.Feed("one\r\ntwo\r\nthree");
+    EXPECT_EQ(screen.Text(), "two\nthree");
+    EXPECT_EQ(screen.scrolled(), 1u);
+}
+
+TEST(VtScreen, CursorMovesAndErases) {
+    VtScreen screen(6, 4);
+    screen.Feed("aaaaaa\r\nbbbbbb\r\ncccccc\r\n");
+    screen.Feed("\033[2A\033[K12\r\033[9A\033[2B\033[3C\033[J");
+    EXPECT_EQ(screen.Text(), "aaaaaa\n12\nccc\n");
+    EXPECT_EQ(screen.cursorRow(), 2u);
+    EXPECT_EQ(screen.cursorColumn(), 3u);
+    screen.Feed("\033[999;1H");
+    EXPECT_EQ(screen.cursorRow(), 3u);
+    EXPECT_EQ(screen.cursorColumn(), 0u);
+    EXPECT_EQ(screen.unsupported(), 0u);
+}
+
+TEST(VtScreen, ColorsAndUtf8TakeOneCell) {
+    VtScreen screen(8, 1);
+    // the escape and the UTF-8 character are both split across writes
+    screen.Feed("\033[3");
+    screen.Feed("1m[E]\033[0m \xE2\x96");
+    screen.Feed("\x81!");
+    EXPECT_EQ(screen.Row(0), "[E] \xE2\x96\x81!");
+    EXPECT_EQ(screen.Cell(0, 0).color, 31);
+    EXPECT_EQ(screen.Cell(0, 2).color, 31);
+    EXPECT_EQ(screen.Cell(0, 3).color, 0);
+    EXPECT_EQ(screen.cursorColumn(), 6u);
+    screen.Feed("\033[?25l\033[2J");
+    EXPECT_FALSE(screen.cursorVisible());
+    EXPECT_EQ(screen.Text(), "");
+}
+
+TEST(VtScreen, CountsWhatItDoesNotModel) {
+    VtScreen screen(8, 2);
+    screen.Feed("\0337\033[5S\033[?1049h\x01");
+    EXPECT_EQ(screen.unsupported(), 4u);
+}
+
+// ----------------------------------------------------------------------------
+// The printer seen through a VtScreen
+// ----------------------------------------------------------------------------
+
+namespace {
+
+constexpr int kColumnWidth = 10;
+constexpr size_t kStatusRows = 6;
+constexpr size_t kDefaultRows = 4;
+constexpr size_t kEngineRows = 3;
+
+/// @brief A printer whose output is played on a VtScreen of the size its
+/// sink reports, every frame as soon as it is drawn
+struct ScreenConsole {
+    ScreenConsole(size_t columns, size_t rows)
+        : sink(std::make_shared<CaptureSink>()), screen(columns, rows) {
+        sink->setSize({columns, rows});
+        printer = std::make_unique<ConsoleTablePrinter>(nullptr, kColumnWidth, kDefaultRows, kStatusRows, sink);
+    }
+
+    void Render(bool full_redraw) {
+        printer->printTelemTable(full_redraw);
+        screen.Feed(sink->text());
+        sink->Clear();
+    }
+
+    /// @brief What ThreadManager::WatchResize does on SIGWINCH
+    void Resize(size_t columns) {
+        sink->setSize({columns, screen.rows()});
+        screen.Resize(columns, screen.rows());
+        Render(printer->terminalResized());
+    }
+
+    std::shared_ptr<CaptureSink> sink;
+    std::unique_ptr<ConsoleTablePrinter> printer;
+    VtScreen screen;
+};
+
+/// @brief Text cut to `cells` characters, as ClipToWidth cuts a line
+std::string CutCells(const std::string& text, size_t cells) {
+    size_t count = 0;
+    for (size_t i = 0; i < text.size(); ++i){
+        if ((static_cast<unsigned char>(text[i]) & 0xC0) == 0x80)
+            continue;
+        if (count++ == cells)
+            return text.substr(0, i);
+    }
+    return text;
+}
+
+std::string LevelName(ConsoleLevels level) {
+    switch (level){
+        case VINFO: return "VINFO";
+        case INFO:  return "INFO";
+        case WARN:  return "WARN";
+        case ERROR: return "ERROR";
+    }
+    return "";
+}
+
+uint8_t LevelColor(ConsoleLevels level) {
+    switch (level){
+        case VINFO: return 34;
+        case INFO:  return 32;
+        case WARN:  return 33;
+        case ERROR: return 31;
+    }
+    return 0;
+}
+
+/// @brief What the screen should show, kept without any of the printer's code
+///
+/// Statuses are drawn newest last under a cap that leaves room for the
+/// tables; a table is a title, a header between two separators and its
+/// newest rows, laid out with the columns of its newest row. The exact
+/// table text is only checked while the panes are stacked, unscrolled and
+/// narrower than the terminal; otherwise only the statuses and the frame
+/// height are.
+class ReferenceConsole {
+public:
+    struct Status {
+        ConsoleLevels level;
+        std::string header;
+        std::string data;
+        bool polling;
+    };
+    struct Schema {
+        std::vector<Column> columns;
+    };
+    /// @brief Numbers of a sample (ints kept apart) or the text of an ITelemetryPrint
+    struct Row {
+        size_t schema;
+        std::vector<std::variant<double, int64_t>> values{};
+        std::vector<std::string> text{};
+    };
+    struct Table {
+        std::string name;
+        size_t max_rows;
+        std::deque<Row> rows{};
+        size_t first_column{0};
+    };
+
+    ReferenceConsole(size_t columns, size_t rows) : columns_(columns), rows_(rows) {}
+
+    /// @return the id the printer must hand out, kHiddenStatusId when hidden
+    size_t AddStatus(const Status& status) {
+        if (status.level == VINFO && !verbose_)
+            return kHiddenStatusId;
+        statuses_.push_back(status);
+        return statuses_.size() - 1;
+    }
+    Status& status(size_t id) { return statuses_[id]; }
+    size_t status_count() const { return statuses_.size(); }
+
+    void AddRow(size_t table, const Row& row) {
+        Table& t = tables_[table];
+        t.rows.push_back(row);
+        if (t.rows.size() > t.max_rows)
+            t.rows.pop_front();
+    }
+
+    size_t AddSchema(std::vector<Column> columns) {
+        schemas_.push_back({std::move(columns)});
+        return schemas_.size() - 1;
+    }
+    size_t AddTable(const std::string& name, size_t max_rows) {
+        tables_.push_back({name, max_rows});
+        return tables_.size() - 1;
+    }
+
+    void set_verbose(bool verbose) { verbose_ = verbose; }
+    void set_side_by_side(bool side) { side_by_side_ = side; }
+    void set_columns(size_t columns) { columns_ = columns; }
+    void set_first_column(size_t table, size_t first) { tables_[table].first_column = first; }
+
+    /// @brief Lines of a table, empty when it has no row
+    std::vector<std::string> TableLines(const Table& table) const {
+        std::vector<std::string> lines;
+        if (table.rows.empty())
+            return lines;
+        const Schema& schema = schemas_[table.rows.back().schema];
+        size_t width = schema.columns.size() * kColumnWidth;
+        auto blank = "[" + std::string(width, ' ') + "]";
+        auto place = [](std::string& line, size_t c, ColumnAlign align, std::string text){
+            text = text.substr(0, kColumnWidth);
+            size_t pad = align == ColumnAlign::Center ? (kColumnWidth - text.size()) / 2 : 0;
+            line.replace(1 + c * kColumnWidth + pad, text.size(), text);
+        };
+        if (!table.name.empty())
+            lines.push_back(" " + table.name);
+        lines.push_back("[" + std::string(width, '=') + "]");
+        lines.push_back(blank);
+        for (size_t c = 0; c < schema.columns.size(); ++c)
+            place(lines.back(), c, schema.columns[c].align, schema.columns[c].title);
+        lines.push_back(lines[lines.size() - 2]);
+        for (const Row& row : table.rows){
+            std::string line = blank;
+            for (size_t c = 0; c < schema.columns.size(); ++c){
+                std::string text;
+                if (!row.text.empty()){
+                    if (c < row.text.size())
+                        text = row.text[c];
+                } else if (c < row.values.size()){
+                    if (auto* i = std::get_if<int64_t>(&row.values[c]))
+                        text = fmt::format("{}", *i);
+                    else
+                        text = fmt::format("{:.2f}", std::get<double>(row.values[c]));
+                }
+                place(line, c, schema.columns[c].align, text);
+            }
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    /// @brief Checks the screen: statuses, tables when comparable, the
+    /// blank rest and the cursor parked under the frame
+    void Check(const VtScreen& screen) const {
+        bool titled = false;
+        for (const auto& table : tables_)
+            titled |= !table.rows.empty() && !table.name.empty();
+        bool exact = !side_by_side_;
+        size_t height = 0;
+        std::vector<std::string> table_lines;
+        for (const auto& table : tables_){
+            auto lines = TableLines(table);
+            if (lines.empty())
+                continue;
+            exact &= table.first_column == 0 && lines.back().size() <= columns_;
+            if (side_by_side_)
+                height = std::max(height, lines.size() + (titled && table.name.empty() ? 1 : 0));
+            else
+                height += lines.size();
+            table_lines.insert(table_lines.end(), lines.begin(), lines.end());
+        }
+
+        size_t room = rows_ > height + 1 ? rows_ - height - 1 : 0;
+        size_t shown = std::min({statuses_.size(), kStatusRows, room});
+        size_t first = statuses_.size() - shown;
+        for (size_t r = 0; r < shown; ++r){
+            const Status& status = statuses_[first + r];
+            std::string level = "[" + LevelName(status.level) + "]";
+            std::string expected = CutCells(level + "[" + status.header + "] " + status.data, columns_);
+            expected.erase(expected.find_last_not_of(' ') + 1);
+            if (status.polling)
+                EXPECT_EQ(screen.Row(r).substr(0, expected.size()), expected) << "status row " << r;
+            else
+                EXPECT_EQ(screen.Row(r), expected) << "status row " << r;
+            EXPECT_EQ(screen.Cell(r, 0).color, LevelColor(status.level)) << "status row " << r;
+            if (level.size() < columns_){
+                EXPECT_EQ(screen.Cell(r, level.size()).color, 0) << "status row " << r;
+            }
+        }
+        if (exact){
+            for (size_t i = 0; i < table_lines.size(); ++i)
+                EXPECT_EQ(screen.Row(shown + i), table_lines[i]) << "table line " << i;
+        }
+        for (size_t r = shown + height; r < rows_; ++r)
+            EXPECT_EQ(screen.Row(r), "") << "row " << r << " under the frame";
+        EXPECT_EQ(screen.cursorRow(), shown + height);
+        EXPECT_EQ(screen.cursorColumn(), 0u);
+    }
+
+private:
+    size_t columns_;
+    size_t rows_;
+    bool verbose_{false};
+    bool side_by_side_{false};
+    std::vector<Status> statuses_{};
+    std::vector<Schema> schemas_{};
+    std::vector<Table> tables_{};
+};
+
+/// @brief One random run: the same operations go to a console redrawn by
+/// diffing (what the executor does every frame) and to one repainted in
+/// full each frame; both screens must match byte for byte, and the
+/// reference model
+void RunInterleaving(uint32_t seed, size_t operations) {
+    std::mt19937 rng(seed);
+    auto pick = [&rng](size_t n){ return std::uniform_int_distribution<size_t>(0, n - 1)(rng); };
+
+    size_t columns = 24 + pick(90);
+    size_t rows = 18 + pick(8);
+    ScreenConsole diffed(columns, rows);
+    ScreenConsole repainted(columns, rows);
+    ReferenceConsole reference(columns, rows);
+    ScreenConsole* consoles[] = {&diffed, &repainted};
+
+    std::vector<Column> schema_columns[] = {
+        {{"Time(s)", ColumnAlign::Left}, {"Agl(m)", ColumnAlign::Left}, {"Ias(kt)", ColumnAlign::Left}},
+        {{"Cmd", ColumnAlign::Center}, {"Throttle", ColumnAlign::Center},
+         {"Err", ColumnAlign::Left}, {"A-very-long-title", ColumnAlign::Center}},
+    };
+    std::vector<SchemaHandle> handles;
+    for (const auto& cols : schema_columns){
+        SchemaHandle handle = diffed.printer->registerSchema(cols, 2);
+        ASSERT_EQ(repainted.printer->registerSchema(cols, 2), handle);
+        handles.push_back(handle);
+        reference.AddSchema(cols);
+    }
+    TableId engine = 0;
+    for (ScreenConsole* console : consoles)
+        engine = console->printer->addTable(TableOptions{"Engine", kEngineRows});
+    reference.AddTable("", kDefaultRows);
+    reference.AddTable("Engine", kEngineRows);
+
+    const char* headers[] = {"Nav", "Engine", "Autopilot", "GPS-Receiver-Long-Name"};
+    const char* words[] = {"ok", "climb", "42", "\xC2\xB0""C", "holding", "waypoint-reached", "x"};
+    // table cells are laid out by bytes, keep their text ASCII
+    const char* cells[] = {"ok", "climb", "42", "n/a", "holding", "waypoint-reached", "x"};
+    auto random_status = [&]{
+        IStatusPrint status{static_cast<ConsoleLevels>(pick(4)), headers[pick(4)], ""};
+        std::string data;
+        for (size_t n = pick(14); n > 0; --n)
+            data += std::string(data.empty() ? "" : " ") + words[pick(7)];
+        status.data = std::string_view(data);
+        return status;
+    };
+    auto reference_status = [](const IStatusPrint& status, bool polling){
+        return ReferenceConsole::Status{status.level, std::string(status.header.view()),
+                                        std::string(status.data.view()), polling};
+    };
+
+    std::vector<size_t> polling;
+    auto now = std::chrono::steady_clock::time_point{} + std::chrono::seconds(1);
+
+    for (size_t op = 0; op < operations; ++op){
+        switch (pick(12)){
+        case 0:
+        case 1: { // newStatus
+            IStatusPrint status = random_status();
+            size_t id = reference.AddStatus(reference_status(status, false));
+            for (ScreenConsole* console : consoles)
+                ASSERT_EQ(console->printer->newStatus(status), id);
+            break;
+        }
+        case 2: { // startPolling
+            IStatusPrint status = random_status();
+            size_t id = reference.AddStatus(reference_status(status, true));
+            for (ScreenConsole* console : consoles)
+                ASSERT_EQ(console->printer->startPolling(status), id);
+            if (id != kHiddenStatusId)
+                polling.push_back(id);
+            break;
+        }
+        case 3: { // stopPolling
+            if (polling.empty())
+                break;
+            size_t at = pick(polling.size());
+            size_t id = polling[at];
+            polling.erase(polling.begin() + at);
+            IStatusPrint status = random_status();
+            reference.status(id) = reference_status(status, false);
+            for (ScreenConsole* console : consoles)
+                console->printer->stopPolling(id, status);
+            break;
+        }
+        case 4: { // animation tick
+            now += std::chrono::milliseconds(100 + pick(300));
+            for (ScreenConsole* console : consoles)
+                console->printer->advanceAnimations(now);
+            break;
+        }
+        case 5:
+        case 6: { // addSample
+            size_t schema = pick(2);
+            TableId table = pick(2) ? engine : kDefaultTable;
+            TelemetrySample sample{handles[schema]};
+            sample.table = table;
+            ReferenceConsole::Row row{schema};
+            for (size_t n = pick(schema_columns[schema].size() + 1); n > 0; --n){
+                if (pick(3) == 0){
+                    auto value = static_cast<int64_t>(pick(200000)) - 1000;
+                    sample.push(value);
+                    row.values.emplace_back(value);
+                } else {
+                    // hundredths only, so no value sits on a rounding tie
+                    double value = (static_cast<double>(pick(2000000)) - 50000) / 100.0;
+                    sample.push(value);
+                    row.values.emplace_back(value);
+                }
+            }
+            reference.AddRow(table, row);
+            for (ScreenConsole* console : consoles)
+                console->printer->addSample(sample);
+            break;
+        }
+        case 7: { // addTelemetry, text cells
+            size_t schema = pick(2);
+            ITelemetryPrint telem{schema_columns[schema], {}, pick(2) ? engine : kDefaultTable};
+            for (size_t n = 1 + pick(schema_columns[schema].size()); n > 0; --n)
+                telem.data.push_back(cells[pick(7)]);
+            reference.AddRow(telem.table, {schema, {}, telem.data});
+            for (ScreenConsole* console : consoles)
+                console->printer->addTelemetry(telem);
+            break;
+        }
+        case 8: { // SIGWINCH, the width changes
+            size_t width = 24 + pick(90);
+            reference.set_columns(width);
+            for (ScreenConsole* console : consoles)
+                console->Resize(width);
+            break;
+        }
+        case 9: { // layout and scrolling
+            size_t what = pick(3);
+            if (what == 0){
+                bool side = pick(2);
+                reference.set_side_by_side(side);
+                for (ScreenConsole* console : consoles)
+                    console->printer->setPaneLayout(side ? PaneLayout::SideBySide : PaneLayout::Stacked);
+            } else if (what == 1){
+                TableId table = pick(2) ? engine : kDefaultTable;
+                size_t first = pick(3) == 0 ? pick(4) : 0;
+                reference.set_first_column(table, first);
+                for (ScreenConsole* console : consoles)
+                    console->printer->scrollColumns(table, first);
+            } else {
+                bool verbose = pick(2);
+                reference.set_verbose(verbose);
+                for (ScreenConsole* console : consoles)
+                    console->printer->setVerbose(verbose);
+            }
+            break;
+        }
+        default: { // a frame
+            diffed.Render(false);
+            repainted.Render(true);
+            ASSERT_EQ(diffed.screen, repainted.screen)
+                << "diffed:\n" << diffed.screen.Dump() << "repainted:\n" << repainted.screen.Dump();
+            reference.Check(diffed.screen);
+            if (::testing::Test::HasFailure())
+                FAIL() << "screen:\n" << diffed.screen.Dump();
+            break;
+        }
+        }
+    }
+    diffed.Render(false);
+    repainted.Render(true);
+    ASSERT_EQ(diffed.screen, repainted.screen)
+        << "diffed:\n" << diffed.screen.Dump() << "repainted:\n" << repainted.screen.Dump();
+    reference.Check(diffed.screen);
+    EXPECT_EQ(diffed.screen.unsupported(), 0u);
+    EXPECT_EQ(diffed.screen.scrolled(), 0u);
+}
+
+}  // namespace
+
+TEST(ConsoleScreen, DiffedFramesMatchRepaintsAndTheReference) {
+    constexpr uint32_t kRuns = 2000;
+    for (uint32_t seed = 0; seed < kRuns; ++seed){
+        SCOPED_TRACE("seed " + std::to_string(seed));
+        RunInterleaving(seed, 80);
+        if (::testing::Test::HasFailure())
+            return; // the first failing seed is enough to replay
+    }
+}
+
+TEST(ConsoleScreen, FormatPoolDrawsTheSameFrames) {
+    // tables tall enough for the frame to go to the pool
+    constexpr size_t kTables = 3;
+    constexpr size_t kRows = 40;
+    ScreenConsole single(120, 200);
+    ScreenConsole pooled(120, 200);
+    pooled.printer->setFormatThreads(4);
+    std::mt19937 rng(7);
+    for (ScreenConsole* console : {&single, &pooled}){
+        SchemaHandle schema = console->printer->registerSchema(
+            {{"Time(s)", ColumnAlign::Left}, {"Agl(m)", ColumnAlign::Center}, {"Ias(kt)", ColumnAlign::Left}}, 2);
+        ASSERT_EQ(schema, 0u);
+        for (size_t t = 1; t < kTables; ++t)
+            console->printer->addTable(TableOptions{"Pane " + std::to_string(t), kRows});
+    }
+    for (size_t frame = 0; frame < 200; ++frame){
+        size_t samples = 1 + rng() % 60;
+        for (size_t i = 0; i < samples; ++i){
+            TelemetrySample sample{0};
+            sample.table = static_cast<TableId>(rng() % kTables);
+            sample.push(static_cast<double>(frame) + static_cast<double>(i) / 100.0);
+            sample.push(static_cast<int64_t>(rng() % 5000));
+            sample.push(static_cast<double>(rng() % 100000) / 100.0);
+            for (ScreenConsole* console : {&single, &pooled})
+                console->printer->addSample(sample);
+        }
+        if (frame % 10 == 0)
+            for (ScreenConsole* console : {&single, &pooled})
+                console->printer->newStatus({WARN, "Frame", std::to_string(frame)});
+        if (frame == 100)
+            for (ScreenConsole* console : {&single, &pooled})
+                console->printer->setPaneLayout(PaneLayout::SideBySide);
+        single.Render(false);
+        pooled.Render(false);
+        ASSERT_EQ(single.screen, pooled.screen) << "frame " << frame << "\n" << pooled.screen.Dump();
+    }
+    // the frames compared above really went through the pool
+    EXPECT_EQ(single.printer->pooledFrames(), 0u);
+    EXPECT_GT(pooled.printer->pooledFrames(), 0u);
+}
+
+TEST(ConsoleScreen, RestoresTheTerminalOnShutdown) {
+    ScreenConsole console(40, 10);
+    console.printer->newStatus({INFO, "Nav", "ready"});
+    console.Render(false);
+    console.screen.Feed("\033[?25l");
+    console.printer->shutdown();
+    console.screen.Feed(console.sink->text());
+    // the prompt starts on a fresh last line, the frame scrolled up by one
+    EXPECT_TRUE(console.screen.cursorVisible());
+    EXPECT_EQ(console.screen.cursorRow(), 9u);
+    EXPECT_EQ(console.screen.cursorColumn(), 0u);
+    EXPECT_EQ(console.screen.scrolled(), 1u);
+    EXPECT_EQ(console.screen.unsupported(), 0u);
+}
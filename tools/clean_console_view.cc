@@ -0,0 +1,105 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "console.h"
+#include "shm_console.h"
+#include "shm_ring.h"
+#include "signal_watcher.h"
+
+namespace {
+
+std::atomic<bool> g_stop{false};
+
+void OnSignal(int) { g_stop.store(true, std::memory_order_relaxed); }
+
+}  // namespace
+
+/// @brief Renders the console of a sim started with --shm <name>
+///
+/// --shm <name>      ring to attach to (default clean_console)
+/// --side-by-side    draw extra tables next to the first one
+/// --verbose         draw VINFO statuses too
+/// --rate <hz>       redraw cap (default 30)
+///
+/// Waits for the sim to start, and can be stopped and started again
+/// while the sim keeps running.
+int main(int argc, char** argv)
+{
+    std::string name = "clean_console";
+    bool side_by_side = false;
+    bool verbose = false;
+    double rate_hz = 30.0;
+    for (int i = 1; i < argc; ++i){
+        if (std::strcmp(argv[i], "--shm") == 0 && i + 1 < argc)
+            name = argv[++i];
+        else if (std::strcmp(argv[i], "--side-by-side") == 0)
+            side_by_side = true;
+        else if (std::strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+        else if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+            rate_hz = std::atof(argv[++i]);
+    }
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+
+    ShmRing ring;
+    bool waiting = false;
+    while (!ring.Attach(name)){
+        if (g_stop.load(std::memory_order_relaxed))
+            return 0;
+        if (!waiting)
+            std::cerr << "waiting for /" << name << "...\n";
+        waiting = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    // the viewer keeps no system log, the sim writes its own
+    ConsoleTablePrinter printer(nullptr, 12, 5);
+    printer.setVerbose(verbose);
+    if (side_by_side)
+        printer.setPaneLayout(PaneLayout::SideBySide);
+    ShmViewer viewer(ring);
+
+    // refitted on the render loop, the watcher thread only raises the flag
+    std::atomic<bool> resized{false};
+    SignalWatcher resize_watcher({SIGWINCH}, [&resized](int) {
+        resized.store(true, std::memory_order_relaxed);
+    });
+
+    using clock = std::chrono::steady_clock;
+    const auto frame_interval = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(rate_hz > 0 ? 1.0 / rate_hz : 0.0));
+    auto last_frame = clock::time_point{};
+    bool dirty = false;
+    bool full_redraw = true;
+    while (!g_stop.load(std::memory_order_relaxed)){
+        size_t applied = viewer.Poll(printer, 4096);
+        dirty |= applied > 0;
+
+        if (resized.exchange(false, std::memory_order_relaxed) && printer.terminalResized())
+            dirty = full_redraw = true;
+
+        auto now = clock::now();
+        if (now - last_frame >= frame_interval){
+            if (printer.advanceAnimations(now))
+                dirty = true;
+            if (dirty){
+                printer.printTelemTable(full_redraw);
+                last_frame = now;
+                dirty = false;
+                full_redraw = false;
+            }
+        }
+        if (applied == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    std::cerr << ring.drops() << " messages dropped, " << viewer.orphans()
+              << " rows without a schema or table\n";
+    return 0;
+}